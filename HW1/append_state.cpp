@@ -0,0 +1,121 @@
+#include "append_state.h"
+#include "column_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <fstream>
+#include <sstream>
+#include <system_error>
+
+// Bytes hashed at each end of the covered range
+static const std::size_t sampleBytes = 4096;
+
+std::string appendStateName(const std::string& outputFile) {
+    return outputFile + ".state";
+}
+
+std::uint64_t appendPrefixHash(const char* data, std::size_t offset) {
+    std::size_t head = std::min(offset, sampleBytes);
+    std::size_t tail = std::max(head, offset > sampleBytes ? offset - sampleBytes : 0);
+    std::uint64_t hash = fnv1a(14695981039346656037ULL, data, head);
+    return fnv1a(hash, data + tail, offset - tail);
+}
+
+std::uint64_t appendOutputSize(const std::string& outputFile) {
+    std::error_code ec;
+    std::uintmax_t size = std::filesystem::file_size(outputFile, ec);
+    return ec ? UINT64_MAX : static_cast<std::uint64_t>(size);
+}
+
+void removeAppendState(const std::string& outputFile) {
+    std::remove(appendStateName(outputFile).c_str());
+}
+
+bool loadAppendState(const std::string& stateFile, AppendState& state) {
+    std::ifstream file(stateFile);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::string line;
+    int found = 0;
+    std::uint64_t count = 0;
+    double mean = 0.0, m2 = 0.0, minVal = 0.0, maxVal = 0.0;
+    while (std::getline(file, line)) {
+        std::istringstream iss(line);
+        std::string key, value;
+        if (!std::getline(iss, key, '=') || !std::getline(iss, value)) {
+            continue;
+        }
+        key.erase(std::remove_if(key.begin(), key.end(), ::isspace), key.end());
+        value.erase(std::remove_if(value.begin(), value.end(), ::isspace), value.end());
+
+        // strtod reads the hexadecimal floats exactly
+        if (key == "offset") {
+            state.offset = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "prefix_hash") {
+            state.prefixHash = std::strtoull(value.c_str(), nullptr, 16);
+        } else if (key == "output_size") {
+            state.outputSize = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "column") {
+            state.column = std::atoi(value.c_str());
+        } else if (key == "normalization") {
+            if (!parseNormalizeMode(value, state.normalize)) {
+                continue;
+            }
+        } else if (key == "count") {
+            count = std::strtoull(value.c_str(), nullptr, 10);
+        } else if (key == "mean") {
+            mean = std::strtod(value.c_str(), nullptr);
+        } else if (key == "m2") {
+            m2 = std::strtod(value.c_str(), nullptr);
+        } else if (key == "min") {
+            minVal = std::strtod(value.c_str(), nullptr);
+        } else if (key == "max") {
+            maxVal = std::strtod(value.c_str(), nullptr);
+        } else {
+            continue;
+        }
+        found++;
+    }
+
+    state.stats = RunningStats(count, mean, m2, minVal, maxVal);
+    return found == 10;
+}
+
+bool saveAppendState(const std::string& stateFile, const AppendState& state) {
+    std::string tmpName = stateFile + ".tmp";
+    std::ofstream file(tmpName);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    file << "offset = " << state.offset << "\n";
+    file << "prefix_hash = " << std::hex << state.prefixHash << std::dec << "\n";
+    file << "output_size = " << state.outputSize << "\n";
+    file << "column = " << state.column << "\n";
+    file << "normalization = " << normalizeModeName(state.normalize) << "\n";
+    file << "count = " << state.stats.count() << "\n";
+    file << std::hexfloat;
+    file << "mean = " << state.stats.mean() << "\n";
+    file << "m2 = " << state.stats.m2() << "\n";
+    file << "min = " << state.stats.min() << "\n";
+    file << "max = " << state.stats.max() << "\n";
+    file.close();
+
+    if (!file) {
+        std::remove(tmpName.c_str());
+        return false;
+    }
+
+    // Replaces an existing state, unlike std::rename on Windows
+    std::error_code ec;
+    std::filesystem::rename(tmpName, stateFile, ec);
+    if (ec) {
+        std::remove(tmpName.c_str());
+        return false;
+    }
+    return true;
+}
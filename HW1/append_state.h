@@ -0,0 +1,87 @@
+#ifndef APPEND_STATE_H
+#define APPEND_STATE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+#include "normalization.h"
+#include "statistics.h"
+
+/*
+Accumulator state saved next to a result file (<output_file>.state)
+
+Plain "key = value" lines; the floating-point values are written as
+hexadecimal floats so they are restored bit for bit.
+    offset      bytes of the data file the statistics cover
+    prefix_hash FNV-1a of the first and last bytes before `offset`
+    output_size bytes of the result file when the state was saved
+    column      column index of the data file
+    normalization  mode the result file was written with
+    count, mean, m2, min, max   the RunningStats accumulator
+*/
+
+/**
+ * Statistics of one column up to a byte offset of an append-only data file
+ */
+struct AppendState {
+    std::uint64_t offset;
+    std::uint64_t prefixHash;
+    std::uint64_t outputSize;
+    int column;
+    NormalizeMode normalize;
+    RunningStats stats;
+};
+
+/**
+ * Name of the state file belonging to a result file
+ * @param outputFile: name of the result file
+ * @return state filename
+ */
+std::string appendStateName(const std::string& outputFile);
+
+/**
+ * Hash of the first `offset` bytes of a data file, used to check that the
+ * file only grew since the state was saved
+ * Only the first and last 4 KiB are hashed: enough to notice a replaced
+ * or rewritten file without reading all of it.
+ * @param data: start of the data file
+ * @param offset: end of the hashed range
+ * @return FNV-1a of the sampled bytes
+ */
+std::uint64_t appendPrefixHash(const char* data, std::size_t offset);
+
+/**
+ * Size of a result file, saved in its state so that the state is only
+ * resumed against the output it describes
+ * @param outputFile: name of the result file
+ * @return size in bytes, or UINT64_MAX if the file does not exist
+ */
+std::uint64_t appendOutputSize(const std::string& outputFile);
+
+/**
+ * Delete the state of a result file. Called before the result file is
+ * written, so that an interrupted or non-incremental write never leaves a
+ * state that no longer matches it.
+ * @param outputFile: name of the result file
+ */
+void removeAppendState(const std::string& outputFile);
+
+/**
+ * Load a state file
+ * @param stateFile: name of the state file
+ * @param state: reference to store the state
+ * @return false if the file is missing or incomplete
+ */
+bool loadAppendState(const std::string& stateFile, AppendState& state);
+
+/**
+ * Save a state file (via a temporary file, so an interrupted run never
+ * leaves a partial state behind)
+ * @param stateFile: name of the state file
+ * @param state: state to save
+ * @return true if successful, false otherwise
+ */
+bool saveAppendState(const std::string& stateFile, const AppendState& state);
+
+#endif
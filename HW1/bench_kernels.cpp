@@ -0,0 +1,95 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "stat_kernels.h"
+#include "statistics.h"
+
+/**
+ * Time a kernel and return its throughput
+ * @param bytes: bytes moved by one call
+ * @param runs: number of timed calls (the best one is reported)
+ * @param kernel: function to time
+ * @return throughput in GB/s
+ */
+double measureGBs(double bytes, int runs, const std::function<void()>& kernel) {
+    kernel(); // Warm-up: page in the buffers
+    double best = 1e30;
+    for (int run = 0; run < runs; run++) {
+        auto start = std::chrono::high_resolution_clock::now();
+        kernel();
+        auto end = std::chrono::high_resolution_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    return bytes / best / 1e9;
+}
+
+int main(int argc, char* argv[]) {
+    std::size_t n = argc > 1 ? std::stoul(argv[1]) : (std::size_t(1) << 24);
+    int runs = argc > 2 ? std::stoi(argv[2]) : 5;
+
+    std::mt19937 gen(42);
+    std::normal_distribution<double> dist(1000.0, 25.0);
+    std::vector<double> data(n);
+    for (double& value : data) {
+        value = dist(gen);
+    }
+    std::vector<double> out(n);
+
+    SimdLevel best = detectSimdLevel();
+    std::cout << "Values: " << n << " (" << n * sizeof(double) / (1 << 20) << " MiB), "
+              << "best instruction set: " << simdLevelName(best) << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << std::left << std::setw(28) << "Kernel" << "GB/s" << std::endl;
+    std::cout << std::setw(28) << "------" << "----" << std::endl;
+
+    // Statistics: mean, stddev, min and max
+    double bytes = static_cast<double>(n * sizeof(double));
+    double sink = 0.0;
+    double reference = measureGBs(bytes, runs, [&]() {
+        double mean = calculateMean(data);
+        double stdDev = calculateStdDev(data, mean);
+        double minVal = *std::min_element(data.begin(), data.end());
+        double maxVal = *std::max_element(data.begin(), data.end());
+        sink += mean + stdDev + minVal + maxVal;
+    });
+    std::cout << std::setw(28) << "stats (4 scalar passes)" << reference << std::endl;
+    for (int l = 0; l <= static_cast<int>(best); l++) {
+        SimdLevel level = static_cast<SimdLevel>(l);
+        double gbs = measureGBs(bytes, runs, [&]() {
+            ColumnMoments m = computeMoments(data.data(), n, level);
+            sink += m.mean() + std::sqrt(m.variance()) + m.min + m.max;
+        });
+        std::cout << std::setw(28) << std::string("moments ") + simdLevelName(level) << gbs
+                  << "  (x" << gbs / reference << ")" << std::endl;
+    }
+
+    // Normalization: one read and one write per value
+    bytes = static_cast<double>(2 * n * sizeof(double));
+    double minVal = *std::min_element(data.begin(), data.end());
+    double maxVal = *std::max_element(data.begin(), data.end());
+    reference = measureGBs(bytes, runs, [&]() {
+        std::vector<double> normalized = normalizeData(data);
+        sink += normalized[n / 2];
+    });
+    std::cout << std::setw(28) << "normalizeData" << reference << std::endl;
+    for (int l = 0; l <= static_cast<int>(best); l++) {
+        SimdLevel level = static_cast<SimdLevel>(l);
+        double gbs = measureGBs(bytes, runs, [&]() {
+            normalizeRange(data.data(), out.data(), n, minVal, maxVal, level);
+            sink += out[n / 2];
+        });
+        std::cout << std::setw(28) << std::string("normalize ") + simdLevelName(level) << gbs
+                  << "  (x" << gbs / reference << ")" << std::endl;
+    }
+
+    // Keep the results alive so the timed work is not optimized away
+    std::cout << "(checksum " << sink << ")" << std::endl;
+    return 0;
+}
@@ -0,0 +1,387 @@
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "csv_reader.h"
+#include "normalization.h"
+#include "output_writer.h"
+#include "sketches.h"
+#include "stat_kernels.h"
+#include "statistics.h"
+
+/**
+ * Settings of a benchmark run, from the command line
+ */
+struct BenchOptions {
+    std::size_t rows;
+    int columns;
+    std::string distribution; // uniform, normal, lognormal or mixed
+    unsigned seed;
+    unsigned numThreads;      // 0 means one per core
+    int runs;                 // timed repetitions, the best one is reported
+    std::string dataFile;     // generated CSV
+    bool keep;                // keep the generated CSV afterwards
+    bool legacy;              // include the line-by-line reference paths
+    std::string jsonFile;
+    std::string csvFile;
+};
+
+/**
+ * One timed stage of the pipeline
+ */
+struct BenchResult {
+    std::string stage;
+    std::string method;
+    double seconds;
+    std::size_t rows;
+    double bytes; // bytes read or written by the stage
+
+    double rowsPerSecond() const { return static_cast<double>(rows) / seconds; }
+    double megabytesPerSecond() const { return bytes / seconds / 1e6; }
+};
+
+/**
+ * Function to generate a synthetic CSV file
+ * Each column draws from the chosen distribution; "mixed" cycles through
+ * uniform, normal, lognormal and small integers across the columns.
+ * Values are written with 4 decimals, like the sample data sets.
+ * @param filename: name of the file to create
+ * @param options: rows, columns, distribution and seed
+ * @return true if successful, false otherwise
+ */
+bool writeSyntheticCsv(const std::string& filename, const BenchOptions& options) {
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    std::mt19937_64 gen(options.seed);
+    std::uniform_real_distribution<double> uniform(0.0, 100.0);
+    std::normal_distribution<double> normal(50.0, 10.0);
+    std::lognormal_distribution<double> lognormal(1.0, 0.75);
+    std::uniform_int_distribution<int> integer(0, 20);
+    std::vector<int> kinds(options.columns);
+    for (int c = 0; c < options.columns; c++) {
+        if (options.distribution == "normal") kinds[c] = 1;
+        else if (options.distribution == "lognormal") kinds[c] = 2;
+        else if (options.distribution == "mixed") kinds[c] = c % 4;
+        else kinds[c] = 0;
+    }
+
+    std::string header;
+    for (int c = 0; c < options.columns; c++) {
+        header += (c == 0 ? "c" : ",c") + std::to_string(c);
+    }
+    header += "\n";
+    file.write(header.data(), static_cast<std::streamsize>(header.size()));
+
+    std::vector<char> buffer(1 << 20);
+    std::size_t used = 0;
+    for (std::size_t row = 0; row < options.rows; row++) {
+        if (buffer.size() - used < static_cast<std::size_t>(options.columns) * 32) {
+            file.write(buffer.data(), static_cast<std::streamsize>(used));
+            used = 0;
+        }
+        for (int c = 0; c < options.columns; c++) {
+            double value;
+            switch (kinds[c]) {
+            case 1: value = normal(gen); break;
+            case 2: value = lognormal(gen); break;
+            case 3: value = integer(gen); break;
+            default: value = uniform(gen); break;
+            }
+            if (c > 0) {
+                buffer[used++] = ',';
+            }
+            char* first = buffer.data() + used;
+            used += static_cast<std::size_t>(
+                std::to_chars(first, buffer.data() + buffer.size(), value, std::chars_format::fixed, 4).ptr - first);
+        }
+        buffer[used++] = '\n';
+    }
+    file.write(buffer.data(), static_cast<std::streamsize>(used));
+    file.close();
+    return !file.fail();
+}
+
+/**
+ * Time a stage
+ * @param runs: number of timed calls (the best one is reported)
+ * @param stage: function to time
+ * @return best time in seconds
+ */
+double measureSeconds(int runs, const std::function<void()>& stage) {
+    double best = 1e30;
+    for (int run = 0; run < runs; run++) {
+        auto start = std::chrono::steady_clock::now();
+        stage();
+        auto end = std::chrono::steady_clock::now();
+        best = std::min(best, std::chrono::duration<double>(end - start).count());
+    }
+    return best;
+}
+
+/**
+ * Function to write a result file the way the original program did:
+ * formatted iostream output with std::endl after every value
+ */
+void writeResultsLegacy(const std::string& filename, double mean, double stdDev,
+                        const std::vector<double>& normalizedData) {
+    std::ofstream file(filename);
+    file << std::fixed << std::setprecision(2);
+    file << "Number of parameters read: " << 3 << std::endl;
+    file << "Mean: " << mean << std::endl;
+    file << "Standard deviation: " << stdDev << std::endl;
+    file << "Normalized data:" << std::endl;
+    for (double value : normalizedData) {
+        file << value << std::endl;
+    }
+}
+
+/**
+ * Function to write one result file with ResultWriter
+ */
+void writeResultsBuffered(const std::string& filename, OutputFormat format, double mean, double stdDev,
+                          const std::vector<double>& normalizedData) {
+    ResultWriter writer;
+    writer.open(filename, format, 3, mean, stdDev, normalizedData.size());
+    writer.append(normalizedData.data(), normalizedData.size());
+    writer.close();
+}
+
+/**
+ * Size of a file in bytes (0 if it does not exist)
+ */
+double fileBytes(const std::string& filename) {
+    std::ifstream file(filename, std::ios::binary | std::ios::ate);
+    return file.is_open() ? static_cast<double>(file.tellg()) : 0.0;
+}
+
+/**
+ * Function to read the command line
+ * @return false (after printing the usage) on an unknown or incomplete option
+ */
+bool parseOptions(int argc, char* argv[], BenchOptions& options) {
+    options.rows = 1000000;
+    options.columns = 8;
+    options.distribution = "mixed";
+    options.seed = 42;
+    options.numThreads = 0;
+    options.runs = 3;
+    options.dataFile = "bench_synthetic.csv";
+    options.keep = false;
+    options.legacy = true;
+
+    for (int i = 1; i < argc; i++) {
+        std::string arg = argv[i];
+        bool hasValue = i + 1 < argc;
+        if (arg == "--keep") {
+            options.keep = true;
+        } else if (arg == "--no-legacy") {
+            options.legacy = false;
+        } else if (arg == "--rows" && hasValue) {
+            options.rows = static_cast<std::size_t>(std::stod(argv[++i]));
+        } else if (arg == "--columns" && hasValue) {
+            options.columns = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--distribution" && hasValue) {
+            options.distribution = argv[++i];
+        } else if (arg == "--seed" && hasValue) {
+            options.seed = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--threads" && hasValue) {
+            options.numThreads = static_cast<unsigned>(std::stoul(argv[++i]));
+        } else if (arg == "--runs" && hasValue) {
+            options.runs = std::max(1, std::stoi(argv[++i]));
+        } else if (arg == "--data" && hasValue) {
+            options.dataFile = argv[++i];
+        } else if (arg == "--json" && hasValue) {
+            options.jsonFile = argv[++i];
+        } else if (arg == "--csv" && hasValue) {
+            options.csvFile = argv[++i];
+        } else {
+            std::cerr << "Usage: " << argv[0] << " [--rows N] [--columns C]"
+                      << " [--distribution uniform|normal|lognormal|mixed] [--seed S] [--threads T]"
+                      << " [--runs R] [--data FILE] [--keep] [--no-legacy] [--json FILE] [--csv FILE]"
+                      << std::endl;
+            return false;
+        }
+    }
+    return true;
+}
+
+bool writeJson(const std::string& filename, const BenchOptions& options, double dataBytes,
+               const std::vector<BenchResult>& results) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << std::setprecision(9);
+    file << "{\n";
+    file << "  \"rows\": " << options.rows << ",\n";
+    file << "  \"columns\": " << options.columns << ",\n";
+    file << "  \"distribution\": \"" << options.distribution << "\",\n";
+    file << "  \"threads\": " << options.numThreads << ",\n";
+    file << "  \"simd\": \"" << simdLevelName(detectSimdLevel()) << "\",\n";
+    file << "  \"file_bytes\": " << dataBytes << ",\n";
+    file << "  \"results\": [\n";
+    for (std::size_t i = 0; i < results.size(); i++) {
+        const BenchResult& r = results[i];
+        file << "    {\"stage\": \"" << r.stage << "\", \"method\": \"" << r.method << "\", \"seconds\": "
+             << r.seconds << ", \"rows\": " << r.rows << ", \"bytes\": " << r.bytes
+             << ", \"rows_per_s\": " << r.rowsPerSecond() << ", \"mb_per_s\": " << r.megabytesPerSecond()
+             << "}" << (i + 1 < results.size() ? "," : "") << "\n";
+    }
+    file << "  ]\n}\n";
+    return !file.fail();
+}
+
+bool writeCsv(const std::string& filename, const std::vector<BenchResult>& results) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+    file << std::setprecision(9);
+    file << "stage,method,seconds,rows,bytes,rows_per_s,mb_per_s\n";
+    for (const BenchResult& r : results) {
+        file << r.stage << "," << r.method << "," << r.seconds << "," << r.rows << "," << r.bytes << ","
+             << r.rowsPerSecond() << "," << r.megabytesPerSecond() << "\n";
+    }
+    return !file.fail();
+}
+
+int main(int argc, char* argv[]) {
+    BenchOptions options;
+    if (!parseOptions(argc, argv, options)) {
+        return 1;
+    }
+
+    auto start = std::chrono::steady_clock::now();
+    if (!writeSyntheticCsv(options.dataFile, options)) {
+        std::cerr << "Error: Cannot create data file: " << options.dataFile << std::endl;
+        return 1;
+    }
+    double generateSeconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    double dataBytes = fileBytes(options.dataFile);
+    std::cout << "Generated " << options.rows << " rows x " << options.columns << " columns ("
+              << options.distribution << ", " << std::fixed << std::setprecision(1) << dataBytes / 1e6
+              << " MB) in " << generateSeconds << " s" << std::endl;
+
+    std::vector<BenchResult> results;
+    const std::size_t rows = options.rows;
+    const unsigned threads = options.numThreads;
+    double sink = 0.0;
+
+    // Parse: one column with each reader, then every column at once
+    std::vector<double> column;
+    if (options.legacy) {
+        results.push_back({"parse", "readData", measureSeconds(options.runs, [&]() {
+            column = readData(options.dataFile, 0, 0);
+        }), rows, dataBytes});
+    }
+    results.push_back({"parse", "readDataMapped", measureSeconds(options.runs, [&]() {
+        column = readDataMapped(options.dataFile, 0, 0);
+    }), rows, dataBytes});
+    results.push_back({"parse", "readDataParallel", measureSeconds(options.runs, [&]() {
+        column = readDataParallel(options.dataFile, 0, 0, threads);
+    }), rows, dataBytes});
+    results.push_back({"parse", "readColumnsParallel (all)", measureSeconds(options.runs, [&]() {
+        ColumnSet set = readColumnsParallel(options.dataFile, 0, std::vector<int>(), threads);
+        sink += set.values.empty() ? 0.0 : set.values[0].size();
+    }), rows, dataBytes});
+    results.push_back({"parse", "streamColumns (all)", measureSeconds(options.runs, [&]() {
+        streamColumns(options.dataFile, 0, std::vector<int>(), threads, [&sink](ColumnSet& block) {
+            sink += block.values[0].size();
+        });
+    }), rows, dataBytes});
+
+    // Statistics of the first column
+    const std::size_t n = column.size();
+    const double valueBytes = static_cast<double>(n * sizeof(double));
+    if (options.legacy) {
+        results.push_back({"stats", "calculateMean+StdDev+minmax", measureSeconds(options.runs, [&]() {
+            double mean = calculateMean(column);
+            sink += mean + calculateStdDev(column, mean) + *std::min_element(column.begin(), column.end()) +
+                    *std::max_element(column.begin(), column.end());
+        }), n, valueBytes});
+    }
+    ColumnMoments moments = computeMoments(column.data(), n);
+    results.push_back({"stats", "computeMoments", measureSeconds(options.runs, [&]() {
+        moments = computeMoments(column.data(), n);
+    }), n, valueBytes});
+    ColumnSummary summary;
+    results.push_back({"stats", "summarizeColumn (KLL+hist)", measureSeconds(options.runs, [&]() {
+        summary = summarizeColumn(column.data(), n, threads, 200, 64);
+    }), n, valueBytes});
+    double mean = moments.mean();
+    double stdDev = std::sqrt(moments.variance());
+
+    // Normalize: the allocating reference and the in-place modes
+    std::vector<double> normalized;
+    if (options.legacy) {
+        results.push_back({"normalize", "normalizeData", measureSeconds(options.runs, [&]() {
+            normalized = normalizeData(column);
+        }), n, 2 * valueBytes});
+    }
+    NormalizeStats scaling = normalizeStats(summary.stats(), summary.quantiles());
+    std::vector<double> work(column);
+    const NormalizeMode modes[] = {NormalizeMode::MinMax, NormalizeMode::ZScore, NormalizeMode::Robust};
+    const char* modeNames[] = {"normalizeInPlace minmax", "normalizeInPlace zscore", "normalizeInPlace robust"};
+    for (int m = 0; m < 3; m++) {
+        results.push_back({"normalize", modeNames[m], measureSeconds(options.runs, [&]() {
+            std::copy(column.begin(), column.end(), work.begin());
+            normalizeInPlace(ValueSpan(work), modes[m], scaling);
+        }), n, 2 * valueBytes});
+    }
+    normalized.assign(column.size(), 0.0);
+    normalizeRange(column.data(), normalized.data(), n, moments.min, moments.max);
+
+    // Write one result file in each format
+    std::string outputFile = options.dataFile + ".out";
+    if (options.legacy) {
+        double seconds = measureSeconds(options.runs, [&]() {
+            writeResultsLegacy(outputFile, mean, stdDev, normalized);
+        });
+        results.push_back({"write", "iostream text (std::endl)", seconds, n, fileBytes(outputFile)});
+    }
+    const OutputFormat formats[] = {OutputFormat::Text, OutputFormat::Binary, OutputFormat::Npy};
+    const char* formatNames[] = {"ResultWriter text", "ResultWriter binary", "ResultWriter npy"};
+    for (int f = 0; f < 3; f++) {
+        double seconds = measureSeconds(options.runs, [&]() {
+            writeResultsBuffered(outputFile, formats[f], mean, stdDev, normalized);
+        });
+        results.push_back({"write", formatNames[f], seconds, n, fileBytes(outputFile)});
+    }
+    std::remove(outputFile.c_str());
+    if (!options.keep) {
+        std::remove(options.dataFile.c_str());
+    }
+
+    std::cout << std::left << std::setw(12) << "Stage" << std::setw(32) << "Method" << std::right
+              << std::setw(12) << "Seconds" << std::setw(14) << "Mrows/s" << std::setw(12) << "MB/s" << std::endl;
+    for (const BenchResult& r : results) {
+        std::cout << std::left << std::setw(12) << r.stage << std::setw(32) << r.method << std::right
+                  << std::setprecision(4) << std::setw(12) << r.seconds << std::setprecision(2)
+                  << std::setw(14) << r.rowsPerSecond() / 1e6 << std::setw(12) << r.megabytesPerSecond()
+                  << std::endl;
+    }
+
+    if (!options.jsonFile.empty() && !writeJson(options.jsonFile, options, dataBytes, results)) {
+        std::cerr << "Error: Cannot write " << options.jsonFile << std::endl;
+    }
+    if (!options.csvFile.empty() && !writeCsv(options.csvFile, results)) {
+        std::cerr << "Error: Cannot write " << options.csvFile << std::endl;
+    }
+
+    // Keep the results alive so the timed work is not optimized away
+    std::cout << "(checksum " << sink + normalized[n / 2] << ")" << std::endl;
+    return 0;
+}
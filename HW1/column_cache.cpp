@@ -0,0 +1,232 @@
+#include "column_cache.h"
+
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <system_error>
+
+static const char cacheMagic[8] = {'H', 'W', '1', 'C', 'O', 'L', 'S', '\0'};
+static const std::uint32_t cacheVersion = 1;
+static const std::size_t cacheAlignment = 64;
+
+// Fixed-size parts of the file layout
+static const std::size_t headerBytes = 8 + 4 + 4 + 8 + 8 + 8 + 8;
+static const std::size_t entryBytes = 4 + 4 + 8 + 8;
+
+static bool hostIsLittleEndian() {
+    const std::uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+static void putU32(std::vector<char>& out, std::uint32_t value) {
+    for (int i = 0; i < 4; i++) out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+static void putU64(std::vector<char>& out, std::uint64_t value) {
+    for (int i = 0; i < 8; i++) out.push_back(static_cast<char>((value >> (8 * i)) & 0xff));
+}
+
+static std::uint32_t getU32(const char* in) {
+    std::uint32_t value = 0;
+    for (int i = 0; i < 4; i++) value |= static_cast<std::uint32_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    return value;
+}
+
+static std::uint64_t getU64(const char* in) {
+    std::uint64_t value = 0;
+    for (int i = 0; i < 8; i++) value |= static_cast<std::uint64_t>(static_cast<unsigned char>(in[i])) << (8 * i);
+    return value;
+}
+
+std::uint64_t fnv1a(std::uint64_t hash, const char* data, std::size_t size) {
+    for (std::size_t i = 0; i < size; i++) {
+        hash ^= static_cast<unsigned char>(data[i]);
+        hash *= 1099511628211ULL;
+    }
+    return hash;
+}
+
+bool computeSourceKey(const std::string& filename, SourceKey& key) {
+    std::error_code ec;
+    std::filesystem::file_time_type mtime = std::filesystem::last_write_time(filename, ec);
+    if (ec) {
+        return false;
+    }
+    MappedFile file;
+    if (!file.open(filename)) {
+        return false;
+    }
+    key.size = file.size();
+    key.mtime = static_cast<std::int64_t>(mtime.time_since_epoch().count());
+
+    // Hashing everything would cost a full read per run; 16 blocks spread
+    // over the file catch in-place edits that keep size and mtime
+    const std::size_t blockBytes = 64 * 1024;
+    const std::size_t numBlocks = 16;
+    std::uint64_t hash = 14695981039346656037ULL;
+    if (file.size() <= blockBytes * numBlocks) {
+        hash = fnv1a(hash, file.data(), file.size());
+    } else {
+        std::size_t stride = (file.size() - blockBytes) / (numBlocks - 1);
+        for (std::size_t i = 0; i < numBlocks; i++) {
+            hash = fnv1a(hash, file.data() + i * stride, blockBytes);
+        }
+    }
+    key.hash = hash;
+    return true;
+}
+
+std::string columnCacheName(const std::string& dataFile) {
+    return dataFile + ".colcache";
+}
+
+bool loadColumnCache(const std::string& cacheFile, const SourceKey& key, int numLines,
+                     const std::vector<int>& columns, ColumnSet& set) {
+    if (!hostIsLittleEndian()) {
+        return false;
+    }
+    MappedFile file;
+    if (!file.open(cacheFile) || file.size() < headerBytes) {
+        return false;
+    }
+    const char* in = file.data();
+    if (std::memcmp(in, cacheMagic, sizeof(cacheMagic)) != 0 || getU32(in + 8) != cacheVersion) {
+        return false;
+    }
+    std::uint32_t numColumns = getU32(in + 12);
+    if (getU64(in + 16) != key.size || getU64(in + 24) != static_cast<std::uint64_t>(key.mtime) ||
+        getU64(in + 32) != key.hash || getU64(in + 40) != static_cast<std::uint64_t>(numLines)) {
+        return false; // Stale
+    }
+    if (file.size() < headerBytes + numColumns * entryBytes) {
+        return false;
+    }
+
+    std::vector<int> wanted = columns;
+    if (wanted.empty()) {
+        for (std::uint32_t i = 0; i < numColumns; i++) {
+            wanted.push_back(static_cast<int>(getU32(in + headerBytes + i * entryBytes)));
+        }
+    }
+
+    set.columns = wanted;
+    set.values.assign(wanted.size(), std::vector<double>());
+    for (std::size_t w = 0; w < wanted.size(); w++) {
+        bool found = false;
+        for (std::uint32_t i = 0; i < numColumns && !found; i++) {
+            const char* entry = in + headerBytes + i * entryBytes;
+            if (static_cast<int>(getU32(entry)) != wanted[w]) {
+                continue;
+            }
+            std::uint64_t offset = getU64(entry + 8);
+            std::uint64_t count = getU64(entry + 16);
+            if (offset > file.size() || count > (file.size() - offset) / sizeof(double)) {
+                return false; // Truncated
+            }
+            set.values[w].resize(count);
+            std::memcpy(set.values[w].data(), in + offset, count * sizeof(double));
+            found = true;
+        }
+        if (!found) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool saveColumnCache(const std::string& cacheFile, const SourceKey& key, int numLines,
+                     const ColumnSet& set) {
+    if (!hostIsLittleEndian()) {
+        return false;
+    }
+
+    std::vector<char> head;
+    head.insert(head.end(), cacheMagic, cacheMagic + sizeof(cacheMagic));
+    putU32(head, cacheVersion);
+    putU32(head, static_cast<std::uint32_t>(set.columns.size()));
+    putU64(head, key.size);
+    putU64(head, static_cast<std::uint64_t>(key.mtime));
+    putU64(head, key.hash);
+    putU64(head, static_cast<std::uint64_t>(numLines));
+
+    // Lay the columns out after the directory, each one aligned
+    std::uint64_t offset = headerBytes + set.columns.size() * entryBytes;
+    std::vector<std::uint64_t> offsets;
+    for (std::size_t i = 0; i < set.columns.size(); i++) {
+        offset = (offset + cacheAlignment - 1) / cacheAlignment * cacheAlignment;
+        offsets.push_back(offset);
+        putU32(head, static_cast<std::uint32_t>(set.columns[i]));
+        putU32(head, 0);
+        putU64(head, offset);
+        putU64(head, set.values[i].size());
+        offset += set.values[i].size() * sizeof(double);
+    }
+
+    std::string tmpFile = cacheFile + ".tmp";
+    std::ofstream out(tmpFile, std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        return false;
+    }
+    out.write(head.data(), static_cast<std::streamsize>(head.size()));
+    std::uint64_t written = head.size();
+    const char zeros[cacheAlignment] = {};
+    for (std::size_t i = 0; i < set.columns.size(); i++) {
+        out.write(zeros, static_cast<std::streamsize>(offsets[i] - written));
+        out.write(reinterpret_cast<const char*>(set.values[i].data()),
+                  static_cast<std::streamsize>(set.values[i].size() * sizeof(double)));
+        written = offsets[i] + set.values[i].size() * sizeof(double);
+    }
+    out.close();
+    if (!out) {
+        std::remove(tmpFile.c_str());
+        return false;
+    }
+
+    std::error_code ec;
+    std::filesystem::rename(tmpFile, cacheFile, ec);
+    if (ec) {
+        std::remove(tmpFile.c_str());
+        return false;
+    }
+    return true;
+}
+
+ColumnSet readColumnsCached(const std::string& filename, int numLines,
+                            const std::vector<int>& columns, unsigned numThreads) {
+    SourceKey key;
+    if (numLines < 0 || !computeSourceKey(filename, key)) {
+        return readColumnsParallel(filename, numLines, columns, numThreads);
+    }
+
+    std::string cacheFile = columnCacheName(filename);
+    ColumnSet set;
+    if (loadColumnCache(cacheFile, key, numLines, columns, set)) {
+        return set;
+    }
+
+    // Missing or stale: parse every column once and rebuild the sidecar
+    ColumnSet all = readColumnsParallel(filename, numLines, std::vector<int>(), numThreads);
+    if (!saveColumnCache(cacheFile, key, numLines, all)) {
+        std::cerr << "Warning: Cannot write column cache: " << cacheFile << std::endl;
+    }
+    if (columns.empty()) {
+        return all;
+    }
+
+    set.columns = columns;
+    set.values.assign(columns.size(), std::vector<double>());
+    for (std::size_t w = 0; w < columns.size(); w++) {
+        std::vector<int>::const_iterator it = std::find(all.columns.begin(), all.columns.end(), columns[w]);
+        if (it == all.columns.end()) {
+            // Not named in the header, so not in the sidecar either
+            return readColumnsParallel(filename, numLines, columns, numThreads);
+        }
+        set.values[w].swap(all.values[it - all.columns.begin()]);
+    }
+    return set;
+}
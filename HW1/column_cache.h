@@ -0,0 +1,91 @@
+#ifndef COLUMN_CACHE_H
+#define COLUMN_CACHE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include "csv_reader.h"
+
+/*
+Binary columnar sidecar for a CSV file (<data_file>.colcache)
+
+All integers and values are little-endian.
+    header     magic "HW1COLS", version, column count, source key,
+               num_lines the columns were read with
+    directory  one entry per column: column index, byte offset, value count
+    data       raw doubles of each column, 64-byte aligned
+*/
+
+/**
+ * Identity of a source file: a sidecar is only used if all three match
+ */
+struct SourceKey {
+    std::uint64_t size;
+    std::int64_t mtime;
+    std::uint64_t hash; // FNV-1a over sampled blocks of the contents
+};
+
+/**
+ * Fold bytes into a 64-bit FNV-1a hash
+ * @param hash: hash so far (14695981039346656037 to start)
+ * @param data: bytes to add
+ * @param size: number of bytes
+ * @return updated hash
+ */
+std::uint64_t fnv1a(std::uint64_t hash, const char* data, std::size_t size);
+
+/**
+ * Compute the key of a file
+ * @param filename: name of the file
+ * @param key: reference to store the key
+ * @return true if successful, false otherwise
+ */
+bool computeSourceKey(const std::string& filename, SourceKey& key);
+
+/**
+ * Name of the sidecar belonging to a data file
+ * @param dataFile: name of the data file
+ * @return sidecar filename
+ */
+std::string columnCacheName(const std::string& dataFile);
+
+/**
+ * Load columns from a sidecar through a memory mapping
+ * @param cacheFile: name of the sidecar
+ * @param key: key of the current source file
+ * @param numLines: num_lines the columns must have been read with
+ * @param columns: column indices to load (empty means all)
+ * @param set: reference to store the columns
+ * @return false if the sidecar is missing, stale or lacks a column
+ */
+bool loadColumnCache(const std::string& cacheFile, const SourceKey& key, int numLines,
+                     const std::vector<int>& columns, ColumnSet& set);
+
+/**
+ * Write columns to a sidecar (via a temporary file, so readers never see
+ * a partial sidecar)
+ * @param cacheFile: name of the sidecar
+ * @param key: key of the source file the columns were read from
+ * @param numLines: num_lines the columns were read with
+ * @param set: columns to store
+ * @return true if successful, false otherwise
+ */
+bool saveColumnCache(const std::string& cacheFile, const SourceKey& key, int numLines,
+                     const ColumnSet& set);
+
+/**
+ * readColumnsParallel() backed by the sidecar cache
+ * A missing or stale sidecar is rebuilt from a full parse of every column,
+ * so later runs can ask for any subset without touching the CSV.
+ * @param filename: name of the data file
+ * @param numLines: number of lines to read (0 means all)
+ * @param columns: distinct column indices to read (empty means all)
+ * @param numThreads: number of parser threads (0 means one per core)
+ * @return one contiguous array of values per requested column
+ */
+ColumnSet readColumnsCached(const std::string& filename, int numLines,
+                            const std::vector<int>& columns, unsigned numThreads);
+
+#endif
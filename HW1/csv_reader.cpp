@@ -0,0 +1,514 @@
+#include "csv_reader.h"
+
+#include <algorithm>
+#include <cctype>
+#include <charconv>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <sstream>
+#include <system_error>
+#include <thread>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+#ifdef _WIN32
+MappedFile::MappedFile() : data_(nullptr), size_(0), file_(INVALID_HANDLE_VALUE), mapping_(nullptr) {}
+#else
+MappedFile::MappedFile() : data_(nullptr), size_(0) {}
+#endif
+
+MappedFile::~MappedFile() {
+    close();
+}
+
+bool MappedFile::open(const std::string& filename) {
+    close();
+#ifdef _WIN32
+    file_ = CreateFileA(filename.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                        OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file_, &fileSize)) {
+        close();
+        return false;
+    }
+    size_ = static_cast<std::size_t>(fileSize.QuadPart);
+    if (size_ == 0) {
+        return true; // Nothing to map
+    }
+    mapping_ = CreateFileMappingA(file_, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    if (mapping_ == nullptr) {
+        close();
+        return false;
+    }
+    data_ = static_cast<const char*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+    if (data_ == nullptr) {
+        close();
+        return false;
+    }
+#else
+    int fd = ::open(filename.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat st;
+    if (fstat(fd, &st) != 0) {
+        ::close(fd);
+        return false;
+    }
+    size_ = static_cast<std::size_t>(st.st_size);
+    if (size_ == 0) {
+        ::close(fd);
+        return true; // mmap rejects zero-length mappings
+    }
+    void* addr = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd); // The mapping keeps its own reference to the file
+    if (addr == MAP_FAILED) {
+        size_ = 0;
+        return false;
+    }
+    // Rows are consumed front to back, so let the kernel read ahead aggressively
+    madvise(addr, size_, MADV_SEQUENTIAL);
+    data_ = static_cast<const char*>(addr);
+#endif
+    return true;
+}
+
+void MappedFile::close() {
+#ifdef _WIN32
+    if (data_ != nullptr) {
+        UnmapViewOfFile(data_);
+    }
+    if (mapping_ != nullptr) {
+        CloseHandle(mapping_);
+        mapping_ = nullptr;
+    }
+    if (file_ != INVALID_HANDLE_VALUE) {
+        CloseHandle(file_);
+        file_ = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (data_ != nullptr) {
+        munmap(const_cast<char*>(data_), size_);
+    }
+#endif
+    data_ = nullptr;
+    size_ = 0;
+}
+
+const char* skipLine(const char* first, const char* last) {
+    if (first == last) {
+        return last;
+    }
+    const char* newline = static_cast<const char*>(std::memchr(first, '\n', last - first));
+    return newline == nullptr ? last : newline + 1;
+}
+
+const char* skipLines(const char* first, const char* last, std::size_t count) {
+    for (std::size_t i = 0; i < count && first != last; i++) {
+        first = skipLine(first, last);
+    }
+    return first;
+}
+
+std::vector<ByteRange> splitAtLines(const char* first, const char* last,
+                                    std::size_t parts, std::size_t minBytes) {
+    std::vector<ByteRange> ranges;
+    std::size_t total = static_cast<std::size_t>(last - first);
+    if (parts == 0) {
+        parts = 1;
+    }
+    if (minBytes > 0 && total / minBytes < parts) {
+        parts = total / minBytes > 0 ? total / minBytes : 1;
+    }
+
+    const char* begin = first;
+    for (std::size_t i = 1; i <= parts && begin != last; i++) {
+        const char* end = last;
+        if (i < parts) {
+            // Move the nominal split point forward to the next line start
+            const char* target = first + total / parts * i;
+            end = target <= begin ? begin : skipLine(target - 1, last);
+        }
+        if (end != begin) {
+            ranges.push_back(ByteRange(begin, end));
+        }
+        begin = end;
+    }
+    if (ranges.empty()) {
+        ranges.push_back(ByteRange(first, last));
+    }
+    return ranges;
+}
+
+int countFields(const char* first, const char* last) {
+    const char* lineEnd = skipLine(first, last);
+    if (lineEnd == first || *first == '\n' || (*first == '\r' && lineEnd - first <= 2)) {
+        return 0;
+    }
+    return 1 + static_cast<int>(std::count(first, lineEnd, ','));
+}
+
+// Parse one cell the way std::stod would: leading whitespace and a '+'
+// sign are accepted, trailing characters (e.g. '\r') are ignored
+static bool parseCell(const char* first, const char* last, double& value) {
+    while (first != last && std::isspace(static_cast<unsigned char>(*first))) {
+        ++first;
+    }
+    if (first != last && *first == '+') {
+        ++first;
+    }
+    std::from_chars_result result = std::from_chars(first, last, value);
+    return result.ec == std::errc() && result.ptr != first;
+}
+
+std::size_t parseColumnRange(const char* first, const char* last, int column,
+                             std::size_t maxRows, std::vector<double>& out) {
+    std::vector<std::vector<double> > columns(1);
+    columns[0].swap(out);
+    std::size_t rows = parseColumnsRange(first, last, std::vector<int>(1, column), maxRows, columns);
+    columns[0].swap(out);
+    return rows;
+}
+
+std::size_t parseColumnsRange(const char* first, const char* last, const std::vector<int>& columns,
+                              std::size_t maxRows, std::vector<std::vector<double> >& out) {
+    // slot[c] is the output vector of column c, or -1 if c was not requested
+    int lastColumn = -1;
+    for (int column : columns) {
+        lastColumn = std::max(lastColumn, column);
+    }
+    std::vector<int> slot(lastColumn + 1, -1);
+    for (std::size_t i = 0; i < columns.size(); i++) {
+        slot[columns[i]] = static_cast<int>(i);
+    }
+    out.resize(columns.size());
+
+    std::size_t rows = 0;
+    while (first != last && (maxRows == 0 || rows < maxRows)) {
+        const char* lineEnd = static_cast<const char*>(std::memchr(first, '\n', last - first));
+        if (lineEnd == nullptr) {
+            lineEnd = last;
+        }
+
+        // Walk the cells in place, stopping after the last requested one.
+        // A missing cell (short row, or nothing after a trailing comma) is skipped.
+        const char* cell = first;
+        for (int c = 0; c <= lastColumn && cell != lineEnd; c++) {
+            const char* cellEnd = static_cast<const char*>(std::memchr(cell, ',', lineEnd - cell));
+            if (cellEnd == nullptr) {
+                cellEnd = lineEnd;
+            }
+            if (slot[c] >= 0) {
+                double value;
+                if (parseCell(cell, cellEnd, value)) {
+                    out[slot[c]].push_back(value);
+                } else {
+                    std::cerr << "Error parsing value: " << std::string(cell, cellEnd) << std::endl;
+                }
+            }
+            if (cellEnd == lineEnd) {
+                break;
+            }
+            cell = cellEnd + 1;
+        }
+
+        rows++;
+        first = lineEnd == last ? last : lineEnd + 1;
+    }
+    return rows;
+}
+
+std::vector<double> readData(const std::string& filename, int numLines, int column) {
+    std::vector<double> data;
+    std::ifstream file(filename);
+    
+    if (!file.is_open()) {
+        std::cerr << "Error: Cannot open data file: " << filename << std::endl;
+        return data;
+    }
+    
+    std::string line;
+    int lineCount = 0;
+    bool firstLine = true;
+    
+    while (std::getline(file, line) && (numLines == 0 || lineCount < numLines)) {
+        if (firstLine) {
+            firstLine = false; // Skip header
+            continue;
+        }
+        
+        std::istringstream iss(line);
+        std::string cell;
+        int currentColumn = 0;
+        
+        while (std::getline(iss, cell, ',')) {
+            if (currentColumn == column) {
+                try {
+                    double value = std::stod(cell);
+                    data.push_back(value);
+                    break;
+                } catch (const std::exception& e) {
+                    std::cerr << "Error parsing value: " << cell << std::endl;
+                }
+            }
+            currentColumn++;
+        }
+        lineCount++;
+    }
+    
+    file.close();
+    return data;
+}
+
+std::vector<double> readDataMapped(const std::string& filename, int numLines, int column) {
+    std::vector<double> data;
+    MappedFile file;
+
+    if (!file.open(filename)) {
+        std::cerr << "Error: Cannot open data file: " << filename << std::endl;
+        return data;
+    }
+    if (numLines < 0 || column < 0) {
+        return data;
+    }
+    if (numLines > 0) {
+        data.reserve(numLines);
+    }
+
+    const char* first = file.data();
+    const char* last = first + file.size();
+    first = skipLine(first, last); // Skip header
+    parseColumnRange(first, last, column, static_cast<std::size_t>(numLines), data);
+
+    return data;
+}
+
+std::vector<double> readDataParallel(const std::string& filename, int numLines, int column,
+                                     unsigned numThreads) {
+    if (column < 0) {
+        return std::vector<double>();
+    }
+    ColumnSet set = readColumnsParallel(filename, numLines, std::vector<int>(1, column), numThreads);
+    return set.values.empty() ? std::vector<double>() : std::move(set.values[0]);
+}
+
+std::vector<int> resolveColumns(const char* first, const char* last, const std::vector<int>& columns) {
+    if (!columns.empty()) {
+        return columns;
+    }
+    // '*': every column named in the header
+    std::vector<int> all;
+    int numFields = countFields(first, last);
+    for (int c = 0; c < numFields; c++) {
+        all.push_back(c);
+    }
+    return all;
+}
+
+std::size_t parseColumnsParallel(const char* first, const char* last, const std::vector<int>& columns,
+                                 unsigned numThreads, std::vector<std::vector<double> >& out) {
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Below ~1 MiB per thread, start-up cost outweighs the parsing work
+    const std::size_t minChunkBytes = 1 << 20;
+    std::vector<ByteRange> chunks = splitAtLines(first, last, numThreads, minChunkBytes);
+    if (chunks.size() == 1) {
+        return parseColumnsRange(first, last, columns, 0, out);
+    }
+
+    std::vector<std::vector<std::vector<double> > > parts(chunks.size());
+    std::vector<std::size_t> rows(chunks.size(), 0);
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < chunks.size(); i++) {
+        workers.emplace_back([&chunks, &parts, &rows, &columns, i]() {
+            rows[i] = parseColumnsRange(chunks[i].first, chunks[i].second, columns, 0, parts[i]);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    // Stitch the chunks back together in row order, column by column
+    out.resize(columns.size());
+    for (std::size_t col = 0; col < columns.size(); col++) {
+        std::size_t total = out[col].size();
+        for (const std::vector<std::vector<double> >& part : parts) {
+            total += part[col].size();
+        }
+        out[col].reserve(total);
+        for (std::size_t i = 0; i < parts.size(); i++) {
+            out[col].insert(out[col].end(), parts[i][col].begin(), parts[i][col].end());
+            std::vector<double>().swap(parts[i][col]);
+        }
+    }
+
+    std::size_t totalRows = 0;
+    for (std::size_t count : rows) {
+        totalRows += count;
+    }
+    return totalRows;
+}
+
+ColumnSet readColumnsParallel(const std::string& filename, int numLines,
+                              const std::vector<int>& columns, unsigned numThreads) {
+    ColumnSet set;
+    MappedFile file;
+
+    if (!file.open(filename)) {
+        std::cerr << "Error: Cannot open data file: " << filename << std::endl;
+        return set;
+    }
+    if (numLines < 0) {
+        return set;
+    }
+
+    const char* first = file.data();
+    const char* last = first + file.size();
+    set.columns = resolveColumns(first, last, columns);
+    set.values.resize(set.columns.size());
+    if (set.columns.empty()) {
+        return set;
+    }
+
+    first = skipLine(first, last); // Skip header
+    if (numLines > 0) {
+        // Cut the input after the last requested row so every chunk can
+        // simply parse to its end
+        last = skipLines(first, last, static_cast<std::size_t>(numLines));
+    }
+    parseColumnsParallel(first, last, set.columns, numThreads, set.values);
+
+    return set;
+}
+
+ColumnSet readColumnsForLimits(const std::string& filename, const std::vector<int>& limits,
+                               const std::vector<int>& columns, unsigned numThreads,
+                               std::vector<std::vector<std::size_t> >& counts) {
+    ColumnSet set;
+    MappedFile file;
+    counts.assign(limits.size(), std::vector<std::size_t>());
+
+    if (!file.open(filename)) {
+        std::cerr << "Error: Cannot open data file: " << filename << std::endl;
+        return set;
+    }
+
+    const char* first = file.data();
+    const char* last = first + file.size();
+    set.columns = resolveColumns(first, last, columns);
+    set.values.resize(set.columns.size());
+    first = skipLine(first, last); // Skip header
+
+    // Visit the limits in increasing order; 0 (all rows) comes last and a
+    // negative limit reads nothing
+    std::vector<std::size_t> rowLimit(limits.size());
+    std::vector<std::size_t> order(limits.size());
+    for (std::size_t i = 0; i < limits.size(); i++) {
+        rowLimit[i] = limits[i] == 0 ? std::numeric_limits<std::size_t>::max()
+                                     : static_cast<std::size_t>(std::max(limits[i], 0));
+        order[i] = i;
+    }
+    std::sort(order.begin(), order.end(), [&rowLimit](std::size_t a, std::size_t b) {
+        return rowLimit[a] < rowLimit[b];
+    });
+
+    std::size_t rowsDone = 0;
+    for (std::size_t index : order) {
+        if (!set.columns.empty() && rowLimit[index] > rowsDone) {
+            const char* end = last;
+            if (rowLimit[index] != std::numeric_limits<std::size_t>::max()) {
+                end = skipLines(first, last, rowLimit[index] - rowsDone);
+            }
+            parseColumnsParallel(first, end, set.columns, numThreads, set.values);
+            first = end;
+            rowsDone = rowLimit[index];
+        }
+        for (const std::vector<double>& values : set.values) {
+            counts[index].push_back(values.size());
+        }
+    }
+
+    return set;
+}
+
+bool streamColumns(const std::string& filename, int numLines, const std::vector<int>& columns,
+                   unsigned numThreads, const std::function<void(ColumnSet&)>& consume) {
+    std::ifstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Error: Cannot open data file: " << filename << std::endl;
+        return false;
+    }
+    if (numLines < 0) {
+        return true;
+    }
+
+    // The buffer only grows if a single line does not fit into it
+    std::vector<char> buffer(16 << 20);
+    std::size_t filled = 0;
+    std::size_t rowsLeft = static_cast<std::size_t>(numLines);
+    bool headerDone = false;
+    bool eof = false;
+    ColumnSet block;
+
+    while (!eof) {
+        file.read(buffer.data() + filled, static_cast<std::streamsize>(buffer.size() - filled));
+        filled += static_cast<std::size_t>(file.gcount());
+        eof = !file;
+
+        const char* first = buffer.data();
+        const char* end = first + filled;
+        const char* last = end;
+        if (!eof) {
+            // Only parse complete lines; the partial one is carried over
+            while (last != first && last[-1] != '\n') {
+                --last;
+            }
+            if (last == first) {
+                buffer.resize(buffer.size() * 2);
+                continue;
+            }
+        }
+
+        if (!headerDone) {
+            block.columns = resolveColumns(first, last, columns);
+            if (block.columns.empty()) {
+                return true;
+            }
+            first = skipLine(first, last); // Skip header
+            headerDone = true;
+        }
+        if (numLines > 0) {
+            last = skipLines(first, last, rowsLeft);
+        }
+
+        block.values.assign(block.columns.size(), std::vector<double>());
+        std::size_t rows = parseColumnsParallel(first, last, block.columns, numThreads, block.values);
+        consume(block);
+
+        if (numLines > 0) {
+            rowsLeft -= rows;
+            if (rowsLeft == 0) {
+                break;
+            }
+        }
+        std::size_t tail = static_cast<std::size_t>(end - last);
+        std::memmove(buffer.data(), last, tail);
+        filled = tail;
+    }
+
+    return true;
+}
@@ -0,0 +1,222 @@
+#ifndef CSV_READER_H
+#define CSV_READER_H
+
+#include <cstddef>
+#include <functional>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Byte range [first, last) of a mapped buffer
+typedef std::pair<const char*, const char*> ByteRange;
+
+/**
+ * Columnar (structure-of-arrays) result of a multi-column read:
+ * values[i] holds every value parsed from column columns[i], stored
+ * contiguously.
+ */
+struct ColumnSet {
+    std::vector<int> columns;
+    std::vector<std::vector<double> > values;
+};
+
+/**
+ * Read-only memory mapping of a whole file.
+ * The file contents are accessed in place through data()/size() and the
+ * mapping is released when the object goes out of scope.
+ */
+class MappedFile {
+public:
+    MappedFile();
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    /**
+     * Map a file into memory
+     * @param filename: name of the file to map
+     * @return true if successful, false otherwise
+     */
+    bool open(const std::string& filename);
+    void close();
+    const char* data() const { return data_; }
+    std::size_t size() const { return size_; }
+
+private:
+    const char* data_;
+    std::size_t size_;
+#ifdef _WIN32
+    void* file_;
+    void* mapping_;
+#endif
+};
+
+/**
+ * Return a pointer to the first byte after the line starting at `first`
+ * @param first: start of the line
+ * @param last: end of the buffer
+ * @return start of the next line, or `last` if there is none
+ */
+const char* skipLine(const char* first, const char* last);
+
+/**
+ * Return a pointer to the first byte after the `count`-th line starting at `first`
+ * @param first: start of the first line
+ * @param last: end of the buffer
+ * @param count: number of lines to skip
+ * @return start of the line after them, or `last` if the buffer ends first
+ */
+const char* skipLines(const char* first, const char* last, std::size_t count);
+
+/**
+ * Count the comma-separated fields of the line starting at `first`
+ * @param first: start of the line
+ * @param last: end of the buffer
+ * @return number of fields (an empty line has none)
+ */
+int countFields(const char* first, const char* last);
+
+/**
+ * Split [first, last) into at most `parts` ranges that start and end on
+ * line boundaries, so each range can be parsed independently
+ * Ranges smaller than `minBytes` are merged with their neighbour.
+ * @param first: start of the first line
+ * @param last: end of the buffer
+ * @param parts: requested number of ranges
+ * @param minBytes: minimum size of a range in bytes
+ * @return ranges in file order, covering [first, last) exactly
+ */
+std::vector<ByteRange> splitAtLines(const char* first, const char* last,
+                                    std::size_t parts, std::size_t minBytes);
+
+/**
+ * Parse the rows in [first, last) and append the values of one column
+ * Rows follow std::getline semantics: an empty line counts as a row, a
+ * trailing '\n' does not start a new one.
+ * @param first: start of the first row
+ * @param last: end of the buffer
+ * @param column: column index to read (0-based)
+ * @param maxRows: maximum number of rows to consume (0 means all)
+ * @param out: vector the parsed values are appended to
+ * @return number of rows consumed
+ */
+std::size_t parseColumnRange(const char* first, const char* last, int column,
+                             std::size_t maxRows, std::vector<double>& out);
+
+/**
+ * Multi-column version of parseColumnRange()
+ * Every row is tokenized once and the values of all requested columns are
+ * appended to their own output vector.
+ * @param first: start of the first row
+ * @param last: end of the buffer
+ * @param columns: distinct, non-negative column indices to read
+ * @param maxRows: maximum number of rows to consume (0 means all)
+ * @param out: one vector per requested column, resized to columns.size()
+ * @return number of rows consumed
+ */
+std::size_t parseColumnsRange(const char* first, const char* last, const std::vector<int>& columns,
+                              std::size_t maxRows, std::vector<std::vector<double> >& out);
+
+/**
+ * Resolve the requested column list against the header line
+ * @param first: start of the header line
+ * @param last: end of the buffer
+ * @param columns: requested column indices (empty means all)
+ * @return `columns`, or every column of the header if it is empty
+ */
+std::vector<int> resolveColumns(const char* first, const char* last, const std::vector<int>& columns);
+
+/**
+ * Parse the rows in [first, last) with parseColumnsRange() on several threads
+ * @param first: start of the first row
+ * @param last: end of the buffer, on a line boundary
+ * @param columns: distinct, non-negative column indices to read
+ * @param numThreads: number of worker threads (0 means one per core)
+ * @param out: one vector per requested column; values are appended in row order
+ * @return number of rows consumed
+ */
+std::size_t parseColumnsParallel(const char* first, const char* last, const std::vector<int>& columns,
+                                 unsigned numThreads, std::vector<std::vector<double> >& out);
+
+/**
+ * Function to read data from CSV file
+ * Line-by-line std::getline/std::stod reference implementation; the
+ * readers below return the same values faster.
+ * @param filename: name of the data file
+ * @param numLines: number of lines to read (0 means all)
+ * @param column: column index to read (0-based)
+ * @return vector of data values
+ */
+std::vector<double> readData(const std::string& filename, int numLines, int column);
+
+/**
+ * Function to read data from CSV file through a memory mapping
+ * Same contract as readData(), but cells are located and parsed with
+ * std::from_chars directly in the mapped bytes, without per-line strings
+ * or streams.
+ * @param filename: name of the data file
+ * @param numLines: number of lines to read (0 means all)
+ * @param column: column index to read (0-based)
+ * @return vector of data values
+ */
+std::vector<double> readDataMapped(const std::string& filename, int numLines, int column);
+
+/**
+ * Parallel version of readDataMapped()
+ * The rows are split into newline-aligned byte ranges that are parsed on
+ * separate threads; the per-range vectors are joined back in row order.
+ * The header skip and the num_lines limit behave exactly as in readData().
+ * @param filename: name of the data file
+ * @param numLines: number of lines to read (0 means all)
+ * @param column: column index to read (0-based)
+ * @param numThreads: number of worker threads (0 means one per core)
+ * @return vector of data values
+ */
+std::vector<double> readDataParallel(const std::string& filename, int numLines, int column,
+                                     unsigned numThreads);
+
+/**
+ * Read several columns of a CSV file in a single parallel pass
+ * @param filename: name of the data file
+ * @param numLines: number of lines to read (0 means all)
+ * @param columns: distinct column indices to read (empty means every
+ *                 column listed in the header)
+ * @param numThreads: number of worker threads (0 means one per core)
+ * @return one contiguous array of values per requested column
+ */
+ColumnSet readColumnsParallel(const std::string& filename, int numLines,
+                              const std::vector<int>& columns, unsigned numThreads);
+
+/**
+ * Read several columns once on behalf of several num_lines limits
+ * The rows are parsed in segments that end at each limit, so the values
+ * belonging to a limit are always a prefix of each column.
+ * @param filename: name of the data file
+ * @param limits: num_lines values to serve (0 means all rows)
+ * @param columns: distinct column indices to read (empty means all)
+ * @param numThreads: number of worker threads (0 means one per core)
+ * @param counts: reference to store, for each limit, the number of values
+ *                of every column that fall within it
+ * @return one contiguous array of values per requested column, read up
+ *         to the largest limit
+ */
+ColumnSet readColumnsForLimits(const std::string& filename, const std::vector<int>& limits,
+                               const std::vector<int>& columns, unsigned numThreads,
+                               std::vector<std::vector<std::size_t> >& counts);
+
+/**
+ * Read a CSV file in fixed-size blocks and hand each block of parsed
+ * columns to `consume`, in row order
+ * Memory use is bounded by the block size, independent of the file size.
+ * @param filename: name of the data file
+ * @param numLines: number of lines to read (0 means all)
+ * @param columns: distinct column indices to read (empty means all)
+ * @param numThreads: number of parser threads per block (0 means one per core)
+ * @param consume: callback receiving the values parsed from each block; it
+ *                 may modify them, the block is refilled afterwards
+ * @return true if the file could be opened, false otherwise
+ */
+bool streamColumns(const std::string& filename, int numLines, const std::vector<int>& columns,
+                   unsigned numThreads, const std::function<void(ColumnSet&)>& consume);
+
+#endif
@@ -2,20 +2,107 @@
 #include <iomanip>
 #include <vector>
 #include <fstream>
+#include <functional>
 #include <string>
 #include <sstream>
 #include <algorithm>
+#include <atomic>
 #include <cmath>
+#include <filesystem>
+#include <map>
+#include <thread>
+
+#include "append_state.h"
+#include "column_cache.h"
+#include "csv_reader.h"
+#include "normalization.h"
+#include "output_writer.h"
+#include "sketches.h"
+#include "stat_kernels.h"
+#include "statistics.h"
+
+/**
+ * Settings read from the parameter file
+ */
+struct Parameters {
+    std::string dataFile;
+    int numLines;
+    std::vector<int> columns; // empty means all columns
+    unsigned numThreads;      // 0 means one per core
+    bool streaming;           // bounded-memory two-pass mode
+    bool cache;               // reuse a binary sidecar of the parsed columns
+    bool incremental;         // only parse what was appended since the last run
+    OutputFormat format;      // layout of the result files
+    NormalizeMode normalize;  // scaling applied to the written values
+    std::vector<double> quantiles; // probabilities reported in the summary file
+    std::size_t histogramBins;     // bins of the summary histogram (0 for none)
+};
+
+// Accuracy parameter of the quantile sketch: about 0.8% rank error in
+// about 600 retained values per column
+const std::size_t quantileSketchSize = 200;
+
+/**
+ * Function to parse the value of the `column` parameter
+ * @param value: comma-separated column indices, or "*" for all columns
+ * @param columns: reference to store the distinct column indices
+ *                 (left empty for "*")
+ * @return true if successful, false otherwise
+ */
+bool parseColumnList(const std::string& value, std::vector<int>& columns) {
+    columns.clear();
+    if (value == "*") {
+        return true;
+    }
+    
+    std::istringstream iss(value);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        int column = std::stoi(item);
+        if (column < 0) {
+            return false;
+        }
+        if (std::find(columns.begin(), columns.end(), column) == columns.end()) {
+            columns.push_back(column);
+        }
+    }
+    return !columns.empty();
+}
+
+/**
+ * Function to parse the value of the `quantiles` parameter
+ * @param value: comma-separated probabilities, e.g. 0.25,0.5,0.75
+ * @param quantiles: reference to store the probabilities
+ * @return true if every probability is in [0, 1], false otherwise
+ */
+bool parseQuantileList(const std::string& value, std::vector<double>& quantiles) {
+    quantiles.clear();
+    std::istringstream iss(value);
+    std::string item;
+    while (std::getline(iss, item, ',')) {
+        double p = std::stod(item);
+        if (!(p >= 0.0 && p <= 1.0)) {
+            return false;
+        }
+        quantiles.push_back(p);
+    }
+    return true;
+}
 
 /**
  * Function to read parameters from input file
+ * Required keys: data_file, num_lines, column.
+ * Optional keys: num_threads (default 0), streaming (default 0), cache (default 0),
+ * output_format (text, binary or npy; default text), normalization (minmax, zscore
+ * or robust; default minmax), quantiles (comma-separated
+ * probabilities) and histogram_bins (default 0); either of the last two adds a
+ * summary file per column. incremental (default 0) keeps the statistics in a
+ * state file per output and later runs only parse the appended rows.
  * @param filename: name of the parameter file
- * @param dataFile: reference to store data filename
- * @param numLines: reference to store number of lines to read
- * @param column: reference to store column index to read
+ * @param params: reference to store the parameters
  * @return true if successful, false otherwise
  */
-bool readParameters(const std::string& filename, std::string& dataFile, int& numLines, int& column) {
+bool readParameters(const std::string& filename, Parameters& params) {
     std::ifstream file(filename);
     if (!file.is_open()) {
         std::cerr << "Error: Cannot open parameter file: " << filename << std::endl;
@@ -24,6 +111,14 @@ bool readParameters(const std::string& filename, std::string& dataFile, int& num
     
     std::string line;
     int paramCount = 0;
+    params.numThreads = 0;
+    params.streaming = false;
+    params.cache = false;
+    params.incremental = false;
+    params.format = OutputFormat::Text;
+    params.normalize = NormalizeMode::MinMax;
+    params.quantiles.clear();
+    params.histogramBins = 0;
     
     while (std::getline(file, line)) {
         std::istringstream iss(line);
@@ -35,14 +130,40 @@ bool readParameters(const std::string& filename, std::string& dataFile, int& num
             value.erase(std::remove_if(value.begin(), value.end(), ::isspace), value.end());
             
             if (key == "data_file") {
-                dataFile = value;
+                params.dataFile = value;
                 paramCount++;
             } else if (key == "num_lines") {
-                numLines = std::stoi(value);
+                params.numLines = std::stoi(value);
                 paramCount++;
             } else if (key == "column") {
-                column = std::stoi(value);
-                paramCount++;
+                if (parseColumnList(value, params.columns)) {
+                    paramCount++;
+                }
+            } else if (key == "num_threads") {
+                params.numThreads = static_cast<unsigned>(std::stoul(value));
+            } else if (key == "streaming") {
+                params.streaming = (value == "1" || value == "true");
+            } else if (key == "cache") {
+                params.cache = (value == "1" || value == "true");
+            } else if (key == "incremental") {
+                params.incremental = (value == "1" || value == "true");
+            } else if (key == "output_format") {
+                if (!parseOutputFormat(value, params.format)) {
+                    std::cerr << "Error: Unknown output format: " << value << std::endl;
+                    return false;
+                }
+            } else if (key == "normalization") {
+                if (!parseNormalizeMode(value, params.normalize)) {
+                    std::cerr << "Error: Unknown normalization: " << value << std::endl;
+                    return false;
+                }
+            } else if (key == "quantiles") {
+                if (!parseQuantileList(value, params.quantiles)) {
+                    std::cerr << "Error: Quantiles must be in [0, 1]: " << value << std::endl;
+                    return false;
+                }
+            } else if (key == "histogram_bins") {
+                params.histogramBins = static_cast<std::size_t>(std::stoul(value));
             }
         }
     }
@@ -52,181 +173,697 @@ bool readParameters(const std::string& filename, std::string& dataFile, int& num
 }
 
 /**
- * Function to read data from CSV file
- * @param filename: name of the data file
- * @param numLines: number of lines to read (0 means all)
- * @param column: column index to read (0-based)
- * @return vector of data values
+ * Function to write results to output file
+ * @param filename: name of the output file
+ * @param numParams: number of parameters read
+ * @param mean: mean value
+ * @param stdDev: standard deviation
+ * @param normalizedData: normalized data values
+ * @param count: number of normalized values
+ * @param format: layout of the output file
+ * @return true if successful, false otherwise
  */
-std::vector<double> readData(const std::string& filename, int numLines, int column) {
-    std::vector<double> data;
-    std::ifstream file(filename);
+bool writeResults(const std::string& filename, int numParams, double mean, double stdDev, 
+                  const double* normalizedData, std::size_t count, OutputFormat format = OutputFormat::Text) {
+    ResultWriter writer;
     
-    if (!file.is_open()) {
-        std::cerr << "Error: Cannot open data file: " << filename << std::endl;
-        return data;
+    if (!writer.open(filename, format, numParams, mean, stdDev, count)) {
+        std::cerr << "Error: Cannot create output file: " << filename << std::endl;
+        return false;
     }
     
-    std::string line;
-    int lineCount = 0;
-    bool firstLine = true;
-    
-    while (std::getline(file, line) && (numLines == 0 || lineCount < numLines)) {
-        if (firstLine) {
-            firstLine = false; // Skip header
-            continue;
-        }
-        
-        std::istringstream iss(line);
-        std::string cell;
-        int currentColumn = 0;
-        
-        while (std::getline(iss, cell, ',')) {
-            if (currentColumn == column) {
-                try {
-                    double value = std::stod(cell);
-                    data.push_back(value);
-                    break;
-                } catch (const std::exception& e) {
-                    std::cerr << "Error parsing value: " << cell << std::endl;
-                }
-            }
-            currentColumn++;
+    writer.append(normalizedData, count);
+    if (!writer.close()) {
+        std::cerr << "Error: Cannot write output file: " << filename << std::endl;
+        return false;
+    }
+    return true;
+}
+
+/**
+ * Function to print the summary that binary output files do not contain
+ * @param outputFile: name of the output file the summary belongs to
+ * @param mean: mean value
+ * @param stdDev: standard deviation
+ */
+void printSummary(const std::string& outputFile, double mean, double stdDev) {
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << outputFile << ": Mean: " << mean << ", Standard deviation: " << stdDev << std::endl;
+}
+
+/**
+ * Function to build the name all result files of one column start with
+ * @param dataFile: name of the data file
+ * @param numColumns: number of columns processed in this run
+ * @param column: column index the output belongs to
+ * @return data file name without extension, plus the column for several columns
+ */
+std::string columnBaseName(const std::string& dataFile, std::size_t numColumns, int column) {
+    std::string baseName = dataFile.substr(0, dataFile.find_last_of('.'));
+    if (numColumns > 1) {
+        baseName += "_col" + std::to_string(column);
+    }
+    return baseName;
+}
+
+/**
+ * Function to build the output filename for one column
+ * @param dataFile: name of the data file
+ * @param numColumns: number of columns processed in this run
+ * @param column: column index the output belongs to
+ * @param format: layout of the output file, which picks the extension
+ * @return output filename; a single column keeps the original name
+ */
+std::string outputFileName(const std::string& dataFile, std::size_t numColumns, int column,
+                           OutputFormat format) {
+    return columnBaseName(dataFile, numColumns, column) + "_normalized" + outputExtension(format);
+}
+
+/**
+ * Function to build the summary filename for one column
+ * @param params: parameters read from the parameter file
+ * @param numColumns: number of columns processed in this run
+ * @param column: column index the summary belongs to
+ * @return summary filename, or an empty string if no summary was requested
+ */
+std::string summaryFileName(const Parameters& params, std::size_t numColumns, int column) {
+    if (params.quantiles.empty() && params.histogramBins == 0) {
+        return std::string();
+    }
+    return columnBaseName(params.dataFile, numColumns, column) + "_summary.txt";
+}
+
+/**
+ * Function to pick the size of the quantile sketch
+ * @param params: parameters read from the parameter file
+ * @return quantileSketchSize if quantiles are reported or the robust
+ *         normalization needs them, 0 otherwise
+ */
+std::size_t sketchSize(const Parameters& params) {
+    bool needed = !params.quantiles.empty() || params.normalize == NormalizeMode::Robust;
+    return needed ? quantileSketchSize : 0;
+}
+
+/**
+ * Function to create the summary accumulator requested by the parameters
+ * @param params: parameters read from the parameter file
+ * @return summary with the quantile sketch and histogram enabled as requested
+ */
+ColumnSummary makeSummary(const Parameters& params) {
+    return ColumnSummary(sketchSize(params), params.histogramBins);
+}
+
+/**
+ * Function to compute the statistics of one column, normalize it and
+ * write the result file
+ * The column is normalized in place, so no second buffer of its size is
+ * needed.
+ * @param data: column values, overwritten with the normalized values
+ * @param count: number of values
+ * @param outputFile: name of the output file
+ * @param summaryFile: name of the summary file (empty for none)
+ * @param params: parameters read from the parameter file
+ * @param numThreads: number of threads for the statistics (0 means one per core)
+ * @param mean: reference to store the mean value
+ * @param stdDev: reference to store the standard deviation
+ * @return true if all files were written, false otherwise
+ */
+bool processColumn(double* data, std::size_t count, const std::string& outputFile,
+                   const std::string& summaryFile, const Parameters& params, unsigned numThreads,
+                   double& mean, double& stdDev) {
+    NormalizeStats stats;
+    if (summaryFile.empty() && sketchSize(params) == 0) {
+        // Calculate statistics: sum, sum of squares, min and max in one pass
+        ColumnMoments moments = computeMoments(data, count);
+        stats = {moments.min, moments.max, moments.mean(), std::sqrt(moments.variance()), 0.0, 0.0};
+    } else {
+        // Moments, quantile sketch and histogram in the same pass
+        ColumnSummary summary = summarizeColumn(data, count, numThreads, sketchSize(params),
+                                                params.histogramBins);
+        stats = normalizeStats(summary.stats(), summary.quantiles());
+        if (!summaryFile.empty() && !writeSummary(summaryFile, summary, params.quantiles)) {
+            std::cerr << "Error: Cannot write summary file: " << summaryFile << std::endl;
+            return false;
         }
-        lineCount++;
     }
+    mean = stats.mean;
+    stdDev = stats.stdDev;
     
-    file.close();
-    return data;
+    // Normalize data
+    normalizeInPlace(ValueSpan(data, count), params.normalize, stats);
+    
+    // Write results; an incremental state saved for the old file no longer applies
+    removeAppendState(outputFile);
+    return writeResults(outputFile, 3, mean, stdDev, data, count, params.format);
 }
 
 /**
- * Function to calculate mean of data
- * @param data: vector of data values
- * @return mean value
+ * Function to process all requested columns held in memory
+ * @param params: parameters read from the parameter file
+ * @param outputFiles: reference to store the names of the written files
  */
-double calculateMean(const std::vector<double>& data) {
-    if (data.empty()) return 0.0;
+void processInMemory(const Parameters& params, std::vector<std::string>& outputFiles) {
+    // Read every requested column in a single pass, or from the sidecar
+    ColumnSet set = params.cache
+        ? readColumnsCached(params.dataFile, params.numLines, params.columns, params.numThreads)
+        : readColumnsParallel(params.dataFile, params.numLines, params.columns, params.numThreads);
     
-    double sum = 0.0;
-    for (double value : data) {
-        sum += value;
+    for (std::size_t i = 0; i < set.columns.size(); i++) {
+        std::vector<double>& data = set.values[i];
+        if (data.empty()) {
+            continue;
+        }
+        
+        double mean, stdDev;
+        std::string outputFile = outputFileName(params.dataFile, set.columns.size(), set.columns[i],
+                                                params.format);
+        std::string summaryFile = summaryFileName(params, set.columns.size(), set.columns[i]);
+        if (!processColumn(data.data(), data.size(), outputFile, summaryFile, params, params.numThreads,
+                           mean, stdDev)) {
+            continue;
+        }
+        if (params.format != OutputFormat::Text) {
+            printSummary(outputFile, mean, stdDev);
+        }
+        outputFiles.push_back(outputFile);
+        if (!summaryFile.empty()) {
+            outputFiles.push_back(summaryFile);
+        }
     }
-    return sum / data.size();
 }
 
 /**
- * Function to calculate standard deviation of data
- * @param data: vector of data values
- * @param mean: mean value of the data
- * @return standard deviation
+ * Function to process all requested columns with bounded memory
+ * The first pass accumulates the statistics block by block, the second
+ * pass reads the file again and writes the normalized values as they are
+ * parsed. No column is ever held in memory as a whole.
+ * @param params: parameters read from the parameter file
+ * @param outputFiles: reference to store the names of the written files
  */
-double calculateStdDev(const std::vector<double>& data, double mean) {
-    if (data.size() <= 1) return 0.0;
+void processStreaming(const Parameters& params, std::vector<std::string>& outputFiles) {
+    // Pass 1: statistics, plus the quantile sketches and histograms if requested
+    std::vector<int> columns;
+    std::vector<ColumnSummary> summaries;
+    const bool sketches = sketchSize(params) > 0 || params.histogramBins > 0;
+    bool opened = streamColumns(params.dataFile, params.numLines, params.columns, params.numThreads,
+        [&columns, &summaries, &params, sketches](const ColumnSet& block) {
+            columns = block.columns;
+            summaries.resize(block.columns.size(), makeSummary(params));
+            for (std::size_t i = 0; i < block.columns.size(); i++) {
+                const std::vector<double>& values = block.values[i];
+                if (sketches) {
+                    summaries[i].merge(summarizeColumn(values.data(), values.size(), params.numThreads,
+                                                       sketchSize(params), params.histogramBins));
+                } else {
+                    summaries[i].add(values.data(), values.size());
+                }
+            }
+        });
+    if (!opened) {
+        return;
+    }
     
-    double sumSquaredDiff = 0.0;
-    for (double value : data) {
-        double diff = value - mean;
-        sumSquaredDiff += diff * diff;
+    // Pass 2: normalize and write, one output file per non-empty column
+    std::vector<ResultWriter> writers(columns.size());
+    std::vector<std::string> names(columns.size());
+    std::vector<RunningStats> stats(columns.size());
+    std::vector<NormalizeStats> scaling(columns.size());
+    for (std::size_t i = 0; i < columns.size(); i++) {
+        stats[i] = summaries[i].stats();
+        scaling[i] = normalizeStats(summaries[i].stats(), summaries[i].quantiles());
+        if (stats[i].count() == 0) {
+            continue;
+        }
+        names[i] = outputFileName(params.dataFile, columns.size(), columns[i], params.format);
+        removeAppendState(names[i]);
+        if (!writers[i].open(names[i], params.format, 3, stats[i].mean(), stats[i].stdDev(), stats[i].count())) {
+            std::cerr << "Error: Cannot create output file: " << names[i] << std::endl;
+        }
     }
     
-    return std::sqrt(sumSquaredDiff / (data.size() - 1));
+    streamColumns(params.dataFile, params.numLines, columns, params.numThreads,
+        [&writers, &scaling, &params](ColumnSet& block) {
+            for (std::size_t i = 0; i < block.columns.size(); i++) {
+                if (!writers[i].isOpen()) {
+                    continue;
+                }
+                // The block is rewritten in place and then handed to the writer
+                std::vector<double>& values = block.values[i];
+                normalizeInPlace(ValueSpan(values), params.normalize, scaling[i]);
+                writers[i].append(values.data(), values.size());
+            }
+        });
+    
+    for (std::size_t i = 0; i < columns.size(); i++) {
+        if (!writers[i].isOpen()) {
+            continue;
+        }
+        if (!writers[i].close()) {
+            std::cerr << "Error: Cannot write output file: " << names[i] << std::endl;
+            continue;
+        }
+        if (params.format != OutputFormat::Text) {
+            printSummary(names[i], stats[i].mean(), stats[i].stdDev());
+        }
+        outputFiles.push_back(names[i]);
+        
+        std::string summaryFile = summaryFileName(params, columns.size(), columns[i]);
+        if (summaryFile.empty()) {
+            continue;
+        }
+        if (!writeSummary(summaryFile, summaries[i], params.quantiles)) {
+            std::cerr << "Error: Cannot write summary file: " << summaryFile << std::endl;
+            continue;
+        }
+        outputFiles.push_back(summaryFile);
+    }
 }
 
 /**
- * Function to normalize data to range [0, 1]
- * @param data: vector of data values
- * @return vector of normalized values
+ * Function to process an append-only data file incrementally
+ * The statistics of every column are saved next to its result file along
+ * with the number of bytes they cover. A later run checks that the data
+ * file only grew, parses just the appended rows and merges them in. If
+ * the min and max stay the same, the old min-max normalized values are
+ * still valid and only the new ones are appended; otherwise (or for the
+ * other normalization modes, whose statistics move with every row) the
+ * column is recomputed from the whole file, as it is when the
+ * normalization mode changed. A state that ends partway through a line
+ * (the file was read while a row was being written) is not resumed: the
+ * rest of that row would be parsed as a row of its own, so the column is
+ * recomputed. A state is dropped before its result file is touched and
+ * saved again only once the file is complete, so an interrupted run
+ * recomputes rather than appending twice.
+ * @param params: parameters read from the parameter file
+ * @param outputFiles: reference to store the names of the written files
  */
-std::vector<double> normalizeData(const std::vector<double>& data) {
-    if (data.empty()) return data;
+void processIncremental(const Parameters& params, std::vector<std::string>& outputFiles) {
+    MappedFile file;
+    if (!file.open(params.dataFile)) {
+        std::cerr << "Error: Cannot open data file: " << params.dataFile << std::endl;
+        return;
+    }
+    const char* first = file.data();
+    const char* last = first + file.size();
+    const char* body = skipLine(first, last); // Skip header
+    std::vector<int> columns = resolveColumns(first, last, params.columns);
     
-    double minVal = *std::min_element(data.begin(), data.end());
-    double maxVal = *std::max_element(data.begin(), data.end());
+    // The saved states are used if all of them cover the same unchanged
+    // prefix, which ends with a complete line
+    std::vector<std::string> names(columns.size());
+    std::vector<AppendState> states(columns.size());
+    bool resume = !columns.empty();
+    for (std::size_t i = 0; i < columns.size(); i++) {
+        names[i] = outputFileName(params.dataFile, columns.size(), columns[i], params.format);
+        resume = resume && loadAppendState(appendStateName(names[i]), states[i]) &&
+                 states[i].column == columns[i] && states[i].normalize == params.normalize &&
+                 states[i].offset == states[0].offset &&
+                 states[i].offset >= static_cast<std::uint64_t>(body - first) &&
+                 states[i].offset <= file.size() && first[states[i].offset - 1] == '\n' &&
+                 states[i].prefixHash == appendPrefixHash(first, states[i].offset) &&
+                 states[i].outputSize == appendOutputSize(names[i]);
+    }
     
-    if (maxVal == minVal) {
-        // All values are the same, set to 0.5
-        return std::vector<double>(data.size(), 0.5);
+    std::vector<std::size_t> recompute;
+    if (!resume) {
+        for (std::size_t i = 0; i < columns.size(); i++) {
+            recompute.push_back(i);
+        }
+    } else {
+        // Parse only the appended rows
+        std::vector<std::vector<double> > appended;
+        parseColumnsParallel(first + states[0].offset, last, columns, params.numThreads, appended);
+        appended.resize(columns.size());
+        
+        for (std::size_t i = 0; i < columns.size(); i++) {
+            const RunningStats& before = states[i].stats;
+            RunningStats stats = before;
+            stats.add(appended[i].data(), appended[i].size());
+            if (stats.count() == 0) {
+                continue;
+            }
+            bool moved = params.normalize != NormalizeMode::MinMax && stats.count() != before.count();
+            if (moved || stats.min() != before.min() || stats.max() != before.max()) {
+                recompute.push_back(i);
+                continue;
+            }
+            
+            // Same range: the normalized values on file stay valid
+            removeAppendState(names[i]);
+            ResultWriter writer;
+            if (!writer.reopen(names[i], params.format, 3, stats.mean(), stats.stdDev(), stats.count())) {
+                recompute.push_back(i);
+                continue;
+            }
+            normalizeMinMax(ValueSpan(appended[i]), stats.min(), stats.max());
+            writer.append(appended[i].data(), appended[i].size());
+            if (!writer.close()) {
+                std::cerr << "Error: Cannot write output file: " << names[i] << std::endl;
+                continue;
+            }
+            
+            states[i].offset = file.size();
+            states[i].prefixHash = appendPrefixHash(first, file.size());
+            states[i].stats = stats;
+            states[i].outputSize = appendOutputSize(names[i]);
+            if (!saveAppendState(appendStateName(names[i]), states[i])) {
+                std::cerr << "Error: Cannot write state file: " << appendStateName(names[i]) << std::endl;
+            }
+            if (params.format != OutputFormat::Text) {
+                printSummary(names[i], stats.mean(), stats.stdDev());
+            }
+            outputFiles.push_back(names[i]);
+        }
+    }
+    if (recompute.empty()) {
+        return;
     }
     
-    std::vector<double> normalized;
-    for (double value : data) {
-        double normalizedValue = (value - minVal) / (maxVal - minVal);
-        normalized.push_back(normalizedValue);
+    // Full pass over the columns that are new or changed their range
+    std::vector<int> recomputeColumns;
+    for (std::size_t i : recompute) {
+        recomputeColumns.push_back(columns[i]);
     }
+    std::vector<std::vector<double> > values;
+    parseColumnsParallel(body, last, recomputeColumns, params.numThreads, values);
+    values.resize(recomputeColumns.size());
     
-    return normalized;
+    for (std::size_t r = 0; r < recompute.size(); r++) {
+        std::size_t i = recompute[r];
+        std::vector<double>& data = values[r];
+        if (data.empty()) {
+            continue;
+        }
+        AppendState state;
+        state.offset = file.size();
+        state.prefixHash = appendPrefixHash(first, file.size());
+        state.column = columns[i];
+        state.normalize = params.normalize;
+        state.stats.add(data.data(), data.size());
+        
+        double mean, stdDev;
+        if (!processColumn(data.data(), data.size(), names[i], std::string(), params, params.numThreads,
+                           mean, stdDev)) {
+            continue;
+        }
+        state.outputSize = appendOutputSize(names[i]);
+        if (!saveAppendState(appendStateName(names[i]), state)) {
+            std::cerr << "Error: Cannot write state file: " << appendStateName(names[i]) << std::endl;
+        }
+        if (params.format != OutputFormat::Text) {
+            printSummary(names[i], mean, stdDev);
+        }
+        outputFiles.push_back(names[i]);
+    }
 }
 
 /**
- * Function to write results to output file
- * @param filename: name of the output file
- * @param numParams: number of parameters read
- * @param mean: mean value
- * @param stdDev: standard deviation
- * @param normalizedData: normalized data values
+ * Function to match a filename against a wildcard pattern
+ * @param pattern: pattern where '*' matches any run of characters and '?'
+ *                 any single character
+ * @param name: filename to test
+ * @return true if the name matches
  */
-void writeResults(const std::string& filename, int numParams, double mean, double stdDev, 
-                 const std::vector<double>& normalizedData) {
-    std::ofstream file(filename);
-    
-    if (!file.is_open()) {
-        std::cerr << "Error: Cannot create output file: " << filename << std::endl;
-        return;
+bool wildcardMatch(const char* pattern, const char* name) {
+    if (*pattern == '\0') {
+        return *name == '\0';
+    }
+    if (*pattern == '*') {
+        return wildcardMatch(pattern + 1, name) || (*name != '\0' && wildcardMatch(pattern, name + 1));
     }
+    return *name != '\0' && (*pattern == '?' || *pattern == *name) && wildcardMatch(pattern + 1, name + 1);
+}
+
+/**
+ * Function to expand the batch arguments into parameter filenames
+ * @param args: filenames, wildcard patterns (matched against the files of
+ *              the pattern's directory) or @list files naming one
+ *              argument per line
+ * @return parameter filenames in argument order, patterns sorted by name
+ */
+std::vector<std::string> expandParameterFiles(const std::vector<std::string>& args) {
+    std::vector<std::string> files;
+    for (const std::string& arg : args) {
+        if (!arg.empty() && arg[0] == '@') {
+            std::ifstream list(arg.substr(1));
+            if (!list.is_open()) {
+                std::cerr << "Error: Cannot open parameter list: " << arg.substr(1) << std::endl;
+                continue;
+            }
+            std::vector<std::string> entries;
+            std::string line;
+            while (std::getline(list, line)) {
+                line.erase(std::remove_if(line.begin(), line.end(), ::isspace), line.end());
+                if (!line.empty()) {
+                    entries.push_back(line);
+                }
+            }
+            std::vector<std::string> expanded = expandParameterFiles(entries);
+            files.insert(files.end(), expanded.begin(), expanded.end());
+        } else if (arg.find_first_of("*?") != std::string::npos) {
+            std::filesystem::path pattern(arg);
+            std::filesystem::path directory = pattern.has_parent_path() ? pattern.parent_path() : ".";
+            std::string filePattern = pattern.filename().string();
+            std::vector<std::string> matches;
+            std::error_code ec;
+            for (std::filesystem::directory_iterator it(directory, ec), end; !ec && it != end; it.increment(ec)) {
+                if (it->is_regular_file() && wildcardMatch(filePattern.c_str(), it->path().filename().string().c_str())) {
+                    matches.push_back(pattern.has_parent_path() ? it->path().string() : it->path().filename().string());
+                }
+            }
+            if (matches.empty()) {
+                std::cerr << "Warning: No parameter files match: " << arg << std::endl;
+            }
+            std::sort(matches.begin(), matches.end());
+            files.insert(files.end(), matches.begin(), matches.end());
+        } else {
+            files.push_back(arg);
+        }
+    }
+    return files;
+}
+
+/**
+ * One result file of a batch run: a column of one parameter file
+ */
+struct BatchTask {
+    std::size_t paramIndex;
+    double* data;
+    std::size_t count;
+    bool shared; // data is also used by another task, normalize a copy
+    std::string outputFile;
+    std::string summaryFile;
+    const Parameters* params;
+    bool written;
+    double mean;
+    double stdDev;
+};
+
+/**
+ * Function to process many parameter files in one run
+ * Parameter files are grouped by data file and each data file is parsed
+ * once for its whole group (union of columns, every num_lines limit).
+ * The per-column statistics, normalization and writing are then shared
+ * out to a pool of threads. Streaming and incremental parameter files run
+ * one by one.
+ * @param args: parameter files, patterns or @list files
+ * @return 0 if every parameter file produced output, 1 otherwise
+ */
+int runBatch(const std::vector<std::string>& args) {
+    std::vector<std::string> paramFiles = expandParameterFiles(args);
+    std::vector<Parameters> params(paramFiles.size());
+    std::vector<bool> valid(paramFiles.size(), false);
+    std::vector<std::vector<std::string> > outputFiles(paramFiles.size());
+    std::vector<std::vector<std::string> > replacedFiles(paramFiles.size());
+    std::map<std::string, std::vector<std::size_t> > groups;
     
-    file << std::fixed << std::setprecision(2);
-    file << "Number of parameters read: " << numParams << std::endl;
-    file << "Mean: " << mean << std::endl;
-    file << "Standard deviation: " << stdDev << std::endl;
-    file << "Normalized data:" << std::endl;
+    for (std::size_t p = 0; p < paramFiles.size(); p++) {
+        valid[p] = readParameters(paramFiles[p], params[p]);
+        if (!valid[p]) {
+            std::cerr << "Failed to read parameters from: " << paramFiles[p] << std::endl;
+        } else if (params[p].incremental && params[p].numLines == 0) {
+            processIncremental(params[p], outputFiles[p]);
+        } else if (params[p].streaming) {
+            processStreaming(params[p], outputFiles[p]);
+        } else {
+            groups[params[p].dataFile].push_back(p);
+        }
+    }
     
-    for (double value : normalizedData) {
-        file << value << std::endl;
+    unsigned numThreads = std::max(1u, std::thread::hardware_concurrency());
+    for (const std::pair<const std::string, std::vector<std::size_t> >& group : groups) {
+        // Columns and num_lines limits needed by the whole group
+        std::vector<int> columns;
+        std::vector<int> limits;
+        bool allColumns = false;
+        bool cache = false;
+        for (std::size_t p : group.second) {
+            allColumns = allColumns || params[p].columns.empty();
+            cache = cache || params[p].cache;
+            for (int column : params[p].columns) {
+                if (std::find(columns.begin(), columns.end(), column) == columns.end()) {
+                    columns.push_back(column);
+                }
+            }
+            limits.push_back(params[p].numLines);
+        }
+        if (allColumns) {
+            columns.clear();
+        }
+        
+        // Parse the data file once for the group
+        ColumnSet set;
+        std::vector<std::vector<std::size_t> > counts;
+        if (cache && std::adjacent_find(limits.begin(), limits.end(), std::not_equal_to<int>()) == limits.end()) {
+            set = readColumnsCached(group.first, limits[0], columns, 0);
+            std::vector<std::size_t> sizes;
+            for (const std::vector<double>& values : set.values) {
+                sizes.push_back(values.size());
+            }
+            counts.assign(limits.size(), sizes);
+        } else {
+            set = readColumnsForLimits(group.first, limits, columns, 0, counts);
+        }
+        
+        // One task per (parameter file, column); a later parameter file
+        // writing the same output replaces an earlier one
+        std::vector<BatchTask> tasks;
+        std::map<std::string, std::size_t> taskByOutput;
+        for (std::size_t g = 0; g < group.second.size(); g++) {
+            std::size_t p = group.second[g];
+            std::vector<int> wanted = params[p].columns.empty() ? set.columns : params[p].columns;
+            for (int column : wanted) {
+                std::size_t slot = std::find(set.columns.begin(), set.columns.end(), column) - set.columns.begin();
+                if (slot == set.columns.size() || counts[g][slot] == 0) {
+                    continue;
+                }
+                BatchTask task = {p, set.values[slot].data(), counts[g][slot], false,
+                                  outputFileName(params[p].dataFile, wanted.size(), column, params[p].format),
+                                  summaryFileName(params[p], wanted.size(), column), &params[p],
+                                  false, 0.0, 0.0};
+                std::map<std::string, std::size_t>::iterator it = taskByOutput.find(task.outputFile);
+                if (it != taskByOutput.end()) {
+                    tasks[it->second].count = 0; // Superseded
+                    replacedFiles[tasks[it->second].paramIndex].push_back(task.outputFile + " (replaced by " +
+                                                                          paramFiles[p] + ")");
+                }
+                taskByOutput[task.outputFile] = tasks.size();
+                tasks.push_back(task);
+            }
+        }
+        
+        // Columns used by several tasks cannot be normalized in place
+        std::map<const double*, std::size_t> users;
+        for (const BatchTask& task : tasks) {
+            if (task.count > 0) {
+                users[task.data]++;
+            }
+        }
+        for (BatchTask& task : tasks) {
+            task.shared = users[task.data] > 1;
+        }
+        
+        // Thread pool with atomic work sharing
+        std::atomic<std::size_t> next(0);
+        std::vector<std::thread> workers;
+        for (unsigned t = 0; t < std::min<std::size_t>(numThreads, tasks.size()); t++) {
+            workers.emplace_back([&tasks, &next]() {
+                for (std::size_t i = next++; i < tasks.size(); i = next++) {
+                    BatchTask& task = tasks[i];
+                    if (task.count == 0) {
+                        continue;
+                    }
+                    std::vector<double> copy;
+                    double* data = task.data;
+                    if (task.shared) {
+                        copy.assign(task.data, task.data + task.count);
+                        data = copy.data();
+                    }
+                    task.written = processColumn(data, task.count, task.outputFile, task.summaryFile,
+                                                 *task.params, 1, task.mean, task.stdDev);
+                }
+            });
+        }
+        for (std::thread& worker : workers) {
+            worker.join();
+        }
+        
+        for (const BatchTask& task : tasks) {
+            if (!task.written) {
+                continue;
+            }
+            if (task.params->format != OutputFormat::Text) {
+                printSummary(task.outputFile, task.mean, task.stdDev);
+            }
+            outputFiles[task.paramIndex].push_back(task.outputFile);
+            if (!task.summaryFile.empty()) {
+                outputFiles[task.paramIndex].push_back(task.summaryFile);
+            }
+        }
     }
     
-    file.close();
+    int status = 0;
+    for (std::size_t p = 0; p < paramFiles.size(); p++) {
+        if (!valid[p]) {
+            status = 1;
+            continue;
+        }
+        if (outputFiles[p].empty() && replacedFiles[p].empty()) {
+            std::cerr << "No data read from file: " << params[p].dataFile << " (" << paramFiles[p] << ")" << std::endl;
+            status = 1;
+            continue;
+        }
+        // A parameter file whose outputs were all superseded did not write anything
+        if (!outputFiles[p].empty()) {
+            std::cout << "Processing completed for: " << params[p].dataFile << " (" << paramFiles[p] << ")" << std::endl;
+        }
+        for (const std::string& outputFile : outputFiles[p]) {
+            std::cout << "Output written to: " << outputFile << std::endl;
+        }
+        for (const std::string& outputFile : replacedFiles[p]) {
+            std::cout << "Skipped: " << outputFile << std::endl;
+        }
+    }
+    return status;
 }
 
 int main(int argc, char* argv[]) {
+    if (argc >= 3 && std::string(argv[1]) == "--batch") {
+        return runBatch(std::vector<std::string>(argv + 2, argv + argc));
+    }
     if (argc != 2) {
         std::cerr << "Usage: " << argv[0] << " <parameter_file>" << std::endl;
+        std::cerr << "       " << argv[0] << " --batch <parameter_file|pattern|@list>..." << std::endl;
         return 1;
     }
     
     std::string paramFile = argv[1];
-    std::string dataFile;
-    int numLines, column;
+    Parameters params;
     
     // Read parameters
-    if (!readParameters(paramFile, dataFile, numLines, column)) {
+    if (!readParameters(paramFile, params)) {
         std::cerr << "Failed to read parameters from: " << paramFile << std::endl;
         return 1;
     }
     
-    // Read data
-    std::vector<double> data = readData(dataFile, numLines, column);
-    if (data.empty()) {
-        std::cerr << "No data read from file: " << dataFile << std::endl;
-        return 1;
+    std::vector<std::string> outputFiles;
+    if (params.incremental && params.numLines == 0) {
+        processIncremental(params, outputFiles);
+    } else if (params.streaming) {
+        processStreaming(params, outputFiles);
+    } else {
+        processInMemory(params, outputFiles);
     }
     
-    // Calculate statistics
-    double mean = calculateMean(data);
-    double stdDev = calculateStdDev(data, mean);
-    
-    // Normalize data
-    std::vector<double> normalizedData = normalizeData(data);
-    
-    // Generate output filename
-    std::string outputFile = dataFile.substr(0, dataFile.find_last_of('.')) + "_normalized.txt";
-    
-    // Write results
-    writeResults(outputFile, 3, mean, stdDev, normalizedData);
+    if (outputFiles.empty()) {
+        std::cerr << "No data read from file: " << params.dataFile << std::endl;
+        return 1;
+    }
     
-    std::cout << "Processing completed for: " << dataFile << std::endl;
-    std::cout << "Output written to: " << outputFile << std::endl;
+    std::cout << "Processing completed for: " << params.dataFile << std::endl;
+    for (const std::string& outputFile : outputFiles) {
+        std::cout << "Output written to: " << outputFile << std::endl;
+    }
     
     return 0;
 }
-
@@ -0,0 +1,65 @@
+#include "normalization.h"
+#include "stat_kernels.h"
+
+#include <algorithm>
+
+bool parseNormalizeMode(const std::string& value, NormalizeMode& mode) {
+    if (value == "minmax") {
+        mode = NormalizeMode::MinMax;
+    } else if (value == "zscore") {
+        mode = NormalizeMode::ZScore;
+    } else if (value == "robust") {
+        mode = NormalizeMode::Robust;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* normalizeModeName(NormalizeMode mode) {
+    switch (mode) {
+    case NormalizeMode::ZScore:
+        return "zscore";
+    case NormalizeMode::Robust:
+        return "robust";
+    default:
+        return "minmax";
+    }
+}
+
+NormalizeStats normalizeStats(const RunningStats& stats, const QuantileSketch& quantiles) {
+    NormalizeStats result = {stats.min(), stats.max(), stats.mean(), stats.stdDev(), 0.0, 0.0};
+    if (quantiles.enabled() && quantiles.count() > 0) {
+        result.median = quantiles.quantile(0.5);
+        result.iqr = quantiles.quantile(0.75) - quantiles.quantile(0.25);
+    }
+    return result;
+}
+
+void normalizeMinMax(ValueSpan values, double minVal, double maxVal) {
+    normalizeRange(values.data, values.data, values.size, minVal, maxVal);
+}
+
+void normalizeZScore(ValueSpan values, double mean, double stdDev) {
+    if (stdDev == 0.0) {
+        std::fill(values.begin(), values.end(), 0.0);
+        return;
+    }
+    scaleRange(values.data, values.data, values.size, mean, stdDev);
+}
+
+void normalizeRobust(ValueSpan values, double median, double iqr) {
+    if (iqr == 0.0) {
+        std::fill(values.begin(), values.end(), 0.0);
+        return;
+    }
+    scaleRange(values.data, values.data, values.size, median, iqr);
+}
+
+void normalizeInPlace(ValueSpan values, NormalizeMode mode, const NormalizeStats& stats) {
+    switch (mode) {
+    case NormalizeMode::ZScore: normalizeZScore(values, stats.mean, stats.stdDev); break;
+    case NormalizeMode::Robust: normalizeRobust(values, stats.median, stats.iqr); break;
+    default: normalizeMinMax(values, stats.min, stats.max); break;
+    }
+}
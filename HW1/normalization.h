@@ -0,0 +1,105 @@
+#ifndef NORMALIZATION_H
+#define NORMALIZATION_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+#include "sketches.h"
+#include "statistics.h"
+
+/**
+ * Non-owning view of contiguous values (what std::span<double> is in C++20)
+ * The in-place normalization works on any buffer through it: a column
+ * vector, one block of a streamed file or a writable mapping.
+ */
+struct ValueSpan {
+    double* data;
+    std::size_t size;
+
+    ValueSpan(double* first, std::size_t count) : data(first), size(count) {}
+    ValueSpan(std::vector<double>& values) : data(values.data()), size(values.size()) {}
+
+    double* begin() const { return data; }
+    double* end() const { return data + size; }
+    // Values [offset, offset + count) of this view
+    ValueSpan subspan(std::size_t offset, std::size_t count) const { return ValueSpan(data + offset, count); }
+};
+
+// How a column is rescaled
+enum class NormalizeMode {
+    MinMax, // (x - min) / (max - min) in [0, 1]; 0.5 for a constant column
+    ZScore, // (x - mean) / stdDev; 0 for a constant column
+    Robust  // (x - median) / IQR; 0 if the interquartile range is 0
+};
+
+/**
+ * Column statistics the normalization modes need
+ */
+struct NormalizeStats {
+    double min;
+    double max;
+    double mean;
+    double stdDev;
+    double median; // only used by NormalizeMode::Robust
+    double iqr;    // upper minus lower quartile, only used by NormalizeMode::Robust
+};
+
+/**
+ * Function to parse the value of the `normalization` parameter
+ * @param value: "minmax", "zscore" or "robust"
+ * @param mode: reference to store the mode
+ * @return true if successful, false otherwise
+ */
+bool parseNormalizeMode(const std::string& value, NormalizeMode& mode);
+
+/**
+ * Function to name a normalization mode, as parseNormalizeMode() reads it
+ * @param mode: normalization mode
+ * @return "minmax", "zscore" or "robust"
+ */
+const char* normalizeModeName(NormalizeMode mode);
+
+/**
+ * Function to collect the normalization statistics of a column
+ * @param stats: moments of the whole column
+ * @param quantiles: sketch of the whole column; the median and IQR are
+ *                   left at 0 if it is disabled
+ * @return statistics for normalizeInPlace()
+ */
+NormalizeStats normalizeStats(const RunningStats& stats, const QuantileSketch& quantiles);
+
+/**
+ * Function to normalize values in place with min-max scaling
+ * @param values: values to rewrite
+ * @param minVal: minimum of the whole column
+ * @param maxVal: maximum of the whole column
+ */
+void normalizeMinMax(ValueSpan values, double minVal, double maxVal);
+
+/**
+ * Function to standardize values in place (z-score)
+ * @param values: values to rewrite
+ * @param mean: mean of the whole column
+ * @param stdDev: standard deviation of the whole column
+ */
+void normalizeZScore(ValueSpan values, double mean, double stdDev);
+
+/**
+ * Function to scale values in place around the median by the
+ * interquartile range, which outliers barely move
+ * @param values: values to rewrite
+ * @param median: median of the whole column
+ * @param iqr: interquartile range of the whole column
+ */
+void normalizeRobust(ValueSpan values, double median, double iqr);
+
+/**
+ * Function to normalize values in place without allocating
+ * @param values: values to rewrite; may be one block of a longer column
+ * @param mode: scaling to apply
+ * @param stats: statistics of the whole column
+ */
+void normalizeInPlace(ValueSpan values, NormalizeMode mode, const NormalizeStats& stats);
+
+#endif
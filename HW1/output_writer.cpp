@@ -0,0 +1,264 @@
+#include "output_writer.h"
+
+#include <charconv>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <iomanip>
+#include <system_error>
+#include <utility>
+
+// Longest value to_chars can produce in fixed notation with 2 decimals
+// (-1.8e308), rounded up
+static const std::size_t maxFixedChars = 320;
+
+static bool hostIsLittleEndian() {
+    const std::uint16_t probe = 1;
+    unsigned char first;
+    std::memcpy(&first, &probe, 1);
+    return first == 1;
+}
+
+bool parseOutputFormat(const std::string& value, OutputFormat& format) {
+    if (value == "text") {
+        format = OutputFormat::Text;
+    } else if (value == "binary") {
+        format = OutputFormat::Binary;
+    } else if (value == "npy") {
+        format = OutputFormat::Npy;
+    } else {
+        return false;
+    }
+    return true;
+}
+
+const char* outputExtension(OutputFormat format) {
+    switch (format) {
+    case OutputFormat::Binary: return ".bin";
+    case OutputFormat::Npy: return ".npy";
+    default: return ".txt";
+    }
+}
+
+bool writeSummary(const std::string& filename, const ColumnSummary& summary,
+                  const std::vector<double>& probabilities) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        return false;
+    }
+
+    const RunningStats& stats = summary.stats();
+    file << std::setprecision(10);
+    file << "Count: " << stats.count() << "\n";
+    file << "Mean: " << stats.mean() << "\n";
+    file << "Standard deviation: " << stats.stdDev() << "\n";
+    file << "Min: " << stats.min() << "\n";
+    file << "Max: " << stats.max() << "\n";
+
+    if (summary.quantiles().enabled() && !probabilities.empty()) {
+        file << "Quantiles:\n";
+        for (double p : probabilities) {
+            file << p << ": " << summary.quantiles().quantile(p) << "\n";
+        }
+    }
+
+    const Histogram& histogram = summary.histogram();
+    if (histogram.enabled()) {
+        file << "Histogram (bin start, bin end, count):\n";
+        for (std::size_t i = 0; i < histogram.numBins(); i++) {
+            file << histogram.binLow(i) << "," << histogram.binLow(i) + histogram.binWidth() << ","
+                 << histogram.binCount(i) << "\n";
+        }
+    }
+
+    file.close();
+    return !file.fail();
+}
+
+ResultWriter::ResultWriter(std::size_t bufferBytes)
+    : format_(OutputFormat::Text), buffer_(bufferBytes < 2 * maxFixedChars ? 2 * maxFixedChars : bufferBytes),
+      used_(0) {}
+
+ResultWriter::~ResultWriter() {
+    if (file_.is_open()) {
+        close();
+    }
+}
+
+bool ResultWriter::open(const std::string& filename, OutputFormat format, int numParams,
+                        double mean, double stdDev, std::size_t count) {
+    format_ = format;
+    used_ = 0;
+    // Text mode keeps the platform line endings the iostream version produced
+    file_.open(filename, format == OutputFormat::Text ? std::ios::out : std::ios::out | std::ios::binary);
+    if (!file_.is_open()) {
+        return false;
+    }
+
+    std::string head = header(numParams, mean, stdDev, count);
+    appendText(head.data(), head.size());
+    return true;
+}
+
+bool ResultWriter::reopen(const std::string& filename, OutputFormat format, int numParams,
+                          double mean, double stdDev, std::size_t count) {
+    format_ = format;
+    used_ = 0;
+    std::ios::openmode mode = format == OutputFormat::Text ? std::ios::openmode() : std::ios::binary;
+
+    // Find where the values of the existing file start
+    std::ifstream in(filename, std::ios::in | mode);
+    if (!in.is_open()) {
+        return false;
+    }
+    std::streamoff oldLength = 0;
+    if (format_ == OutputFormat::Text) {
+        std::string line;
+        for (int i = 0; i < 4 && std::getline(in, line); i++) {
+        }
+        if (!in || line != "Normalized data:") {
+            return false;
+        }
+        oldLength = in.tellg();
+    } else if (format_ == OutputFormat::Npy) {
+        char prefix[10];
+        if (!in.read(prefix, sizeof(prefix)) || std::memcmp(prefix, "\x93NUMPY\x01\x00", 8) != 0) {
+            return false;
+        }
+        oldLength = 10 + (static_cast<unsigned char>(prefix[8]) | static_cast<unsigned char>(prefix[9]) << 8);
+    }
+
+    std::string head = header(numParams, mean, stdDev, count);
+    if (static_cast<std::streamoff>(head.size()) == oldLength) {
+        in.close();
+        if (!head.empty()) {
+            std::fstream patch(filename, std::ios::in | std::ios::out | mode);
+            patch.write(head.data(), static_cast<std::streamsize>(head.size()));
+            if (!patch) {
+                return false;
+            }
+        }
+    } else {
+        // The header changed length: copy the values behind a new header
+        std::string tmpName = filename + ".tmp";
+        std::ofstream out(tmpName, std::ios::out | mode);
+        in.clear();
+        in.seekg(oldLength);
+        out.write(head.data(), static_cast<std::streamsize>(head.size()));
+        if (in.peek() != std::ifstream::traits_type::eof()) {
+            out << in.rdbuf();
+        }
+        in.close();
+        out.close();
+        if (!out) {
+            std::remove(tmpName.c_str());
+            return false;
+        }
+        // Replaces the old file, unlike std::rename on Windows
+        std::error_code ec;
+        std::filesystem::rename(tmpName, filename, ec);
+        if (ec) {
+            std::remove(tmpName.c_str());
+            return false;
+        }
+    }
+
+    file_.open(filename, std::ios::out | std::ios::app | mode);
+    return file_.is_open();
+}
+
+std::string ResultWriter::header(int numParams, double mean, double stdDev, std::size_t count) const {
+    char number[maxFixedChars];
+    std::string head;
+    if (format_ == OutputFormat::Text) {
+        head = "Number of parameters read: " + std::to_string(numParams) + "\nMean: ";
+        head.append(number, std::to_chars(number, number + sizeof(number), mean,
+                                           std::chars_format::fixed, 2).ptr);
+        head += "\nStandard deviation: ";
+        head.append(number, std::to_chars(number, number + sizeof(number), stdDev,
+                                           std::chars_format::fixed, 2).ptr);
+        head += "\nNormalized data:\n";
+    } else if (format_ == OutputFormat::Npy) {
+        // Version 1.0 header, padded with spaces so the data starts at a
+        // multiple of 64 bytes
+        std::string dict = "{'descr': '<f8', 'fortran_order': False, 'shape': (" +
+                           std::to_string(count) + ",), }";
+        std::size_t total = 10 + dict.size() + 1;
+        std::size_t padded = (total + 63) / 64 * 64;
+        dict.append(padded - total, ' ');
+        dict.push_back('\n');
+        std::uint16_t headerLength = static_cast<std::uint16_t>(dict.size());
+        const char magic[8] = {'\x93', 'N', 'U', 'M', 'P', 'Y', 1, 0};
+        char length[2] = {static_cast<char>(headerLength & 0xff), static_cast<char>(headerLength >> 8)};
+        head.append(magic, sizeof(magic));
+        head.append(length, sizeof(length));
+        head += dict;
+    }
+    return head;
+}
+
+void ResultWriter::append(const double* values, std::size_t count) {
+    if (format_ == OutputFormat::Text) {
+        for (std::size_t i = 0; i < count; i++) {
+            if (buffer_.size() - used_ < maxFixedChars + 1) {
+                flush();
+            }
+            appendFixed(values[i]);
+            buffer_[used_++] = '\n';
+        }
+        return;
+    }
+
+    // Raw doubles, swapped to little-endian if needed
+    const bool swap = !hostIsLittleEndian();
+    for (std::size_t i = 0; i < count; i++) {
+        if (buffer_.size() - used_ < sizeof(double)) {
+            flush();
+        }
+        char* out = buffer_.data() + used_;
+        std::memcpy(out, &values[i], sizeof(double));
+        if (swap) {
+            for (std::size_t b = 0; b < sizeof(double) / 2; b++) {
+                std::swap(out[b], out[sizeof(double) - 1 - b]);
+            }
+        }
+        used_ += sizeof(double);
+    }
+}
+
+bool ResultWriter::close() {
+    flush();
+    file_.close();
+    return !file_.fail();
+}
+
+void ResultWriter::flush() {
+    if (used_ > 0) {
+        file_.write(buffer_.data(), static_cast<std::streamsize>(used_));
+        used_ = 0;
+    }
+}
+
+void ResultWriter::appendText(const char* text, std::size_t length) {
+    if (buffer_.size() - used_ < length) {
+        flush();
+    }
+    if (length > buffer_.size()) {
+        file_.write(text, static_cast<std::streamsize>(length));
+        return;
+    }
+    std::memcpy(buffer_.data() + used_, text, length);
+    used_ += length;
+}
+
+// Same digits as `std::fixed << std::setprecision(2)`
+void ResultWriter::appendFixed(double value) {
+    if (buffer_.size() - used_ < maxFixedChars) {
+        flush();
+    }
+    char* first = buffer_.data() + used_;
+    std::to_chars_result result = std::to_chars(first, buffer_.data() + buffer_.size(), value,
+                                                std::chars_format::fixed, 2);
+    used_ += static_cast<std::size_t>(result.ptr - first);
+}
@@ -0,0 +1,97 @@
+#ifndef OUTPUT_WRITER_H
+#define OUTPUT_WRITER_H
+
+#include <cstddef>
+#include <fstream>
+#include <string>
+#include <vector>
+
+#include "sketches.h"
+
+// Layout of a result file
+enum class OutputFormat {
+    Text,   // summary lines followed by one value per line, 2 decimals
+    Binary, // raw little-endian doubles, nothing else
+    Npy     // NumPy .npy array of little-endian doubles
+};
+
+/**
+ * Function to parse the value of the `output_format` parameter
+ * @param value: "text", "binary" or "npy"
+ * @param format: reference to store the format
+ * @return true if successful, false otherwise
+ */
+bool parseOutputFormat(const std::string& value, OutputFormat& format);
+
+/**
+ * File extension used for a format, including the dot
+ */
+const char* outputExtension(OutputFormat format);
+
+/**
+ * Function to write the summary file of one column: count, moments,
+ * the requested quantiles and the histogram bins
+ * @param filename: name of the summary file
+ * @param summary: summary of the column
+ * @param probabilities: quantiles to report, each in [0, 1]
+ * @return true if successful, false otherwise
+ */
+bool writeSummary(const std::string& filename, const ColumnSummary& summary,
+                  const std::vector<double>& probabilities);
+
+/**
+ * Writer for one result file
+ * Values are formatted with std::to_chars into a large reusable buffer
+ * that is handed to the stream in few big writes, instead of one
+ * formatted, flushed write per value.
+ */
+class ResultWriter {
+public:
+    explicit ResultWriter(std::size_t bufferBytes = 1 << 20);
+    ~ResultWriter();
+    ResultWriter(const ResultWriter&) = delete;
+    ResultWriter& operator=(const ResultWriter&) = delete;
+
+    /**
+     * Create the file and write its header
+     * The summary is only part of the file in text format.
+     * @param filename: name of the output file
+     * @param format: layout of the file
+     * @param numParams: number of parameters read
+     * @param mean: mean value
+     * @param stdDev: standard deviation
+     * @param count: number of values that will be appended (needed by .npy)
+     * @return true if successful, false otherwise
+     */
+    bool open(const std::string& filename, OutputFormat format, int numParams,
+              double mean, double stdDev, std::size_t count);
+    /**
+     * Reopen an existing result file to append values to it
+     * The header is updated for the new summary and total count; the
+     * values already in the file are kept. The header is patched in place
+     * if its length does not change, otherwise the file is rewritten.
+     * Parameters as for open(), with `count` the total after appending.
+     * @return true if successful, false if the file is missing or is not
+     *         a result file of this format
+     */
+    bool reopen(const std::string& filename, OutputFormat format, int numParams,
+                double mean, double stdDev, std::size_t count);
+    // Append normalized values
+    void append(const double* values, std::size_t count);
+    // Write out the buffer and close the file; false if any write failed
+    bool close();
+    bool isOpen() const { return file_.is_open(); }
+
+private:
+    std::string header(int numParams, double mean, double stdDev, std::size_t count) const;
+    void flush();
+    void appendText(const char* text, std::size_t length);
+    void appendFixed(double value);
+
+    std::ofstream file_;
+    OutputFormat format_;
+    std::vector<char> buffer_;
+    std::size_t used_;
+};
+
+#endif
@@ -1,4 +1,4 @@
-g++ -o data_processor data_processor.cpp
+g++ -std=c++17 -O2 -o data_processor main.cpp csv_reader.cpp column_cache.cpp output_writer.cpp statistics.cpp stat_kernels.cpp sketches.cpp append_state.cpp normalization.cpp
 echo Compiling C++ program...
 if %errorlevel% equ 0 (
     echo Compilation successful!
@@ -0,0 +1,390 @@
+#include "sketches.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <limits>
+#include <thread>
+#include <utility>
+
+// Values buffered in level 0 before it is compacted; sorting a few
+// thousand values at a time keeps the per-value cost of the radix sort low
+static const std::size_t levelZeroBatch = 2048;
+
+/**
+ * LSD radix sort of doubles (no NaNs), 11 bits per pass
+ * The doubles are mapped to unsigned keys with the same order; passes in
+ * which every key has the same digit are skipped, which drops most of the
+ * exponent passes for real data.
+ * @param values: values to sort in place
+ * @param keys: scratch buffer
+ * @param scratch: second scratch buffer
+ */
+static void radixSort(std::vector<double>& values, std::vector<std::uint64_t>& keys,
+                      std::vector<std::uint64_t>& scratch) {
+    const std::size_t n = values.size();
+    const std::uint64_t signBit = std::uint64_t(1) << 63;
+    keys.resize(n);
+    scratch.resize(n);
+    for (std::size_t i = 0; i < n; i++) {
+        std::uint64_t bits;
+        std::memcpy(&bits, &values[i], sizeof(bits));
+        keys[i] = (bits & signBit) ? ~bits : bits | signBit;
+    }
+
+    std::uint64_t* src = keys.data();
+    std::uint64_t* dst = scratch.data();
+    for (int shift = 0; shift < 64; shift += 11) {
+        std::size_t offsets[2048] = {0};
+        for (std::size_t i = 0; i < n; i++) {
+            offsets[(src[i] >> shift) & 2047]++;
+        }
+        if (offsets[(src[0] >> shift) & 2047] == n) {
+            continue;
+        }
+        std::size_t sum = 0;
+        for (std::size_t& offset : offsets) {
+            std::size_t count = offset;
+            offset = sum;
+            sum += count;
+        }
+        for (std::size_t i = 0; i < n; i++) {
+            dst[offsets[(src[i] >> shift) & 2047]++] = src[i];
+        }
+        std::swap(src, dst);
+    }
+
+    for (std::size_t i = 0; i < n; i++) {
+        std::uint64_t bits = (src[i] & signBit) ? src[i] & ~signBit : ~src[i];
+        std::memcpy(&values[i], &bits, sizeof(bits));
+    }
+}
+
+QuantileSketch::QuantileSketch(std::size_t k)
+    : k_(k), count_(0), size_(0), maxSize_(0), random_(0x9E3779B97F4A7C15ull),
+      min_(std::numeric_limits<double>::infinity()),
+      max_(-std::numeric_limits<double>::infinity()) {
+    if (k_ > 0) {
+        k_ = std::max<std::size_t>(k_, 8);
+        levels_.resize(1);
+        maxSize_ = capacity(0);
+    }
+}
+
+std::size_t QuantileSketch::capacity(std::size_t level) const {
+    // Lower levels shrink geometrically, the top level holds k values
+    std::size_t depth = levels_.size() - 1 - level;
+    double capacity = std::ceil(static_cast<double>(k_) * std::pow(2.0 / 3.0, static_cast<double>(depth)));
+    return std::max<std::size_t>(2, static_cast<std::size_t>(capacity));
+}
+
+std::size_t QuantileSketch::totalCapacity() const {
+    std::size_t total = 0;
+    for (std::size_t h = 0; h < levels_.size(); h++) {
+        total += capacity(h);
+    }
+    return total;
+}
+
+void QuantileSketch::add(double value) {
+    if (k_ == 0 || std::isnan(value)) {
+        return;
+    }
+    count_++;
+    if (value < min_) min_ = value;
+    if (value > max_) max_ = value;
+    levels_[0].push_back(value);
+    if (++size_ >= maxSize_ && levels_[0].size() >= std::max(k_, levelZeroBatch)) {
+        compress();
+    }
+}
+
+void QuantileSketch::add(const double* values, std::size_t count) {
+    if (k_ == 0) {
+        return;
+    }
+    for (std::size_t i = 0; i < count; i++) {
+        add(values[i]);
+    }
+}
+
+void QuantileSketch::compress() {
+    // Compact the lowest full level until the sketch is within budget.
+    // Level 0 is only compacted once it holds a batch of values, so each
+    // sort handles many values instead of a handful
+    while (size_ >= maxSize_) {
+        std::size_t h = 0;
+        while (levels_[h].size() < capacity(h)) {
+            h++;
+        }
+        if (h + 1 == levels_.size()) {
+            levels_.emplace_back();
+            maxSize_ = totalCapacity();
+        }
+        std::vector<double>& level = levels_[h];
+        std::vector<double>& next = levels_[h + 1];
+        if (level.size() >= 256) {
+            radixSort(level, keys_, scratch_);
+        } else {
+            std::sort(level.begin(), level.end());
+        }
+
+        // An odd value out stays behind so that the total weight is exact
+        std::size_t pairs = level.size() / 2;
+        double leftOver = level.back();
+        bool odd = level.size() % 2 != 0;
+
+        // Promote the even or the odd half, chosen at random
+        random_ ^= random_ << 13;
+        random_ ^= random_ >> 7;
+        random_ ^= random_ << 17;
+        std::size_t offset = random_ & 1;
+        for (std::size_t i = 0; i < pairs; i++) {
+            next.push_back(level[2 * i + offset]);
+        }
+        level.clear();
+        if (odd) {
+            level.push_back(leftOver);
+        }
+        size_ -= pairs;
+    }
+}
+
+void QuantileSketch::merge(const QuantileSketch& other) {
+    if (k_ == 0 || other.count_ == 0) {
+        return;
+    }
+    if (levels_.size() < other.levels_.size()) {
+        levels_.resize(other.levels_.size());
+    }
+    for (std::size_t h = 0; h < other.levels_.size(); h++) {
+        levels_[h].insert(levels_[h].end(), other.levels_[h].begin(), other.levels_[h].end());
+    }
+    size_ += other.size_;
+    maxSize_ = totalCapacity();
+    count_ += other.count_;
+    min_ = std::min(min_, other.min_);
+    max_ = std::max(max_, other.max_);
+    compress();
+}
+
+double QuantileSketch::quantile(double p) const {
+    if (count_ == 0) {
+        return std::numeric_limits<double>::quiet_NaN();
+    }
+    if (p <= 0.0) return min_;
+    if (p >= 1.0) return max_;
+
+    // Every retained value stands for 2^level input values
+    std::vector<std::pair<double, std::uint64_t> > weighted;
+    weighted.reserve(size_);
+    std::uint64_t total = 0;
+    for (std::size_t h = 0; h < levels_.size(); h++) {
+        for (double value : levels_[h]) {
+            weighted.emplace_back(value, std::uint64_t(1) << h);
+            total += std::uint64_t(1) << h;
+        }
+    }
+    std::sort(weighted.begin(), weighted.end());
+
+    double target = std::ceil(p * static_cast<double>(total));
+    std::uint64_t cumulative = 0;
+    for (const std::pair<double, std::uint64_t>& item : weighted) {
+        cumulative += item.second;
+        if (static_cast<double>(cumulative) >= target) {
+            return item.first;
+        }
+    }
+    return max_;
+}
+
+Histogram::Histogram(std::size_t numBins)
+    : bins_(numBins, 0), count_(0), origin_(0.0), width_(0.0) {}
+
+void Histogram::add(double value) {
+    add(value, 1);
+}
+
+void Histogram::add(const double* values, std::size_t count) {
+    if (bins_.empty()) {
+        return;
+    }
+    std::size_t i = 0;
+    for (; i < count && width_ == 0.0; i++) {
+        add(values[i], 1);
+    }
+
+    // Values inside the current bins only need an index; the width is a
+    // power of two, so scaling by its inverse is exact
+    const std::size_t lastBin = bins_.size() - 1;
+    double scale = 1.0 / width_;
+    double high = binLow(bins_.size());
+    for (; i < count; i++) {
+        double value = values[i];
+        if (value >= origin_ && value < high) {
+            std::size_t bin = static_cast<std::size_t>((value - origin_) * scale);
+            bins_[std::min(bin, lastBin)]++;
+            count_++;
+        } else {
+            add(value, 1);
+            scale = 1.0 / width_;
+            high = binLow(bins_.size());
+        }
+    }
+}
+
+void Histogram::add(double value, std::uint64_t weight) {
+    if (bins_.empty() || !std::isfinite(value)) {
+        return;
+    }
+    if (count_ == 0) {
+        origin_ = value;
+        bins_[0] = weight;
+        count_ = weight;
+        return;
+    }
+    if (width_ == 0.0) {
+        if (value == origin_) {
+            bins_[0] += weight;
+            count_ += weight;
+            return;
+        }
+        // First distinct value: start with bins about 1/n of the spread
+        double spread = std::fabs(value - origin_) / static_cast<double>(bins_.size());
+        width_ = std::ldexp(1.0, std::ilogb(std::max(spread, std::numeric_limits<double>::min())));
+        origin_ = std::floor(origin_ / width_) * width_;
+    }
+    if (!(value >= origin_ && value < binLow(bins_.size()))) {
+        cover(value, value, width_);
+    }
+    std::size_t bin = static_cast<std::size_t>((value - origin_) / width_);
+    bins_[std::min(bin, bins_.size() - 1)] += weight;
+    count_ += weight;
+}
+
+void Histogram::cover(double low, double high, double minWidth) {
+    // Keep every non-empty bin inside the new grid
+    const std::size_t numBins = bins_.size();
+    bool occupied = false;
+    for (std::size_t b = 0; b < numBins; b++) {
+        if (bins_[b] != 0) {
+            low = std::min(low, binLow(b));
+            high = std::max(high, binLow(b));
+            occupied = true;
+        }
+    }
+
+    double width = std::max(width_, minWidth);
+    while (std::floor(high / width) - std::floor(low / width) >= static_cast<double>(numBins)) {
+        width *= 2.0;
+    }
+
+    // Aligned power-of-two grids nest, so each old bin lands in one new bin
+    double first = std::floor(low / width);
+    std::vector<std::uint64_t> bins(numBins, 0);
+    if (occupied) {
+        for (std::size_t b = 0; b < numBins; b++) {
+            if (bins_[b] != 0) {
+                bins[static_cast<std::size_t>(std::floor(binLow(b) / width) - first)] += bins_[b];
+            }
+        }
+    }
+    bins_.swap(bins);
+    origin_ = first * width;
+    width_ = width;
+}
+
+void Histogram::merge(const Histogram& other) {
+    if (bins_.empty() || other.count_ == 0) {
+        return;
+    }
+    if (other.width_ == 0.0) {
+        add(other.origin_, other.count_);
+        return;
+    }
+    if (width_ == 0.0) {
+        // Take over the other grid and fold in the equal values seen so far
+        Histogram equal(*this);
+        *this = other;
+        if (equal.count_ != 0) {
+            add(equal.origin_, equal.count_);
+        }
+        return;
+    }
+
+    double low = std::numeric_limits<double>::infinity();
+    double high = -std::numeric_limits<double>::infinity();
+    for (std::size_t b = 0; b < other.bins_.size(); b++) {
+        if (other.bins_[b] != 0) {
+            low = std::min(low, other.binLow(b));
+            high = std::max(high, other.binLow(b));
+        }
+    }
+    cover(low, high, other.width_);
+
+    double first = std::floor(origin_ / width_);
+    for (std::size_t b = 0; b < other.bins_.size(); b++) {
+        if (other.bins_[b] != 0) {
+            bins_[static_cast<std::size_t>(std::floor(other.binLow(b) / width_) - first)] += other.bins_[b];
+        }
+    }
+    count_ += other.count_;
+}
+
+ColumnSummary::ColumnSummary(std::size_t sketchSize, std::size_t histogramBins)
+    : quantiles_(sketchSize), histogram_(histogramBins) {}
+
+void ColumnSummary::add(const double* values, std::size_t count) {
+    if (!quantiles_.enabled() && !histogram_.enabled()) {
+        stats_.add(values, count);
+        return;
+    }
+    // Feed the three accumulators tile by tile so that each value is
+    // read from memory once and then served from the L1 cache
+    const std::size_t tile = 4096;
+    for (std::size_t i = 0; i < count; i += tile) {
+        std::size_t n = std::min(tile, count - i);
+        stats_.add(values + i, n);
+        quantiles_.add(values + i, n);
+        histogram_.add(values + i, n);
+    }
+}
+
+void ColumnSummary::merge(const ColumnSummary& other) {
+    stats_.merge(other.stats_);
+    quantiles_.merge(other.quantiles_);
+    histogram_.merge(other.histogram_);
+}
+
+ColumnSummary summarizeColumn(const double* data, std::size_t count, unsigned numThreads,
+                              std::size_t sketchSize, std::size_t histogramBins) {
+    if (numThreads == 0) {
+        numThreads = std::max(1u, std::thread::hardware_concurrency());
+    }
+
+    // Below ~64k values per thread, start-up cost outweighs the work
+    const std::size_t minChunk = 1 << 16;
+    std::size_t numChunks = std::max<std::size_t>(1, std::min<std::size_t>(numThreads, count / minChunk));
+    std::vector<ColumnSummary> parts(numChunks, ColumnSummary(sketchSize, histogramBins));
+    if (numChunks == 1) {
+        parts[0].add(data, count);
+        return parts[0];
+    }
+
+    std::vector<std::thread> workers;
+    for (std::size_t i = 0; i < numChunks; i++) {
+        workers.emplace_back([&parts, data, count, numChunks, i]() {
+            std::size_t begin = count * i / numChunks;
+            std::size_t end = count * (i + 1) / numChunks;
+            parts[i].add(data + begin, end - begin);
+        });
+    }
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+
+    for (std::size_t i = 1; i < numChunks; i++) {
+        parts[0].merge(parts[i]);
+    }
+    return parts[0];
+}
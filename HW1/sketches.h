@@ -0,0 +1,140 @@
+#ifndef SKETCHES_H
+#define SKETCHES_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+#include "statistics.h"
+
+/**
+ * Streaming quantile sketch (KLL, Karnin, Lang & Liberty 2016)
+ * Values are kept in a stack of compactors; level h holds values of
+ * weight 2^h. A full level is sorted and every other value is promoted to
+ * the next level, so memory stays around 3k values however many are
+ * added. The rank error is roughly 1.7 / k of the count. Sketches over
+ * disjoint parts of a column can be merged.
+ */
+class QuantileSketch {
+public:
+    // `k` sets accuracy and memory; 0 disables the sketch
+    explicit QuantileSketch(std::size_t k = 200);
+
+    // Add one value
+    void add(double value);
+    // Add `count` contiguous values
+    void add(const double* values, std::size_t count);
+    // Combine with a sketch over a different part of the column
+    void merge(const QuantileSketch& other);
+
+    bool enabled() const { return k_ > 0; }
+    std::uint64_t count() const { return count_; }
+    // Number of values currently held
+    std::size_t retained() const { return size_; }
+
+    /**
+     * Approximate quantile (nearest rank)
+     * @param p: probability in [0, 1]; 0 and 1 give the exact min and max
+     * @return value of rank ceil(p * count), or NaN if the sketch is empty
+     */
+    double quantile(double p) const;
+
+private:
+    std::size_t capacity(std::size_t level) const;
+    std::size_t totalCapacity() const;
+    void compress();
+
+    std::size_t k_;
+    std::uint64_t count_;
+    std::size_t size_;    // values held over all levels
+    std::size_t maxSize_; // sum of the level capacities
+    std::uint64_t random_; // xorshift state for the compaction offsets
+    double min_;
+    double max_;
+    std::vector<std::vector<double> > levels_;
+    std::vector<std::uint64_t> keys_;    // radix sort scratch
+    std::vector<std::uint64_t> scratch_;
+};
+
+/**
+ * Fixed-bin histogram whose range adapts to the data in a single pass
+ * The bin width is a power of two and the lower edge a multiple of it.
+ * When a value falls outside the bins the width is doubled until the
+ * data fits again; because the grids are aligned, every old bin falls
+ * into exactly one new bin, so no count is ever split or estimated and
+ * histograms over disjoint parts of a column can be merged exactly.
+ * The bins span between 1x and 2x the range of the data.
+ */
+class Histogram {
+public:
+    // `numBins` is the fixed number of bins; 0 disables the histogram
+    explicit Histogram(std::size_t numBins = 0);
+
+    // Add one value; NaN and infinities are ignored
+    void add(double value);
+    // Add `count` contiguous values
+    void add(const double* values, std::size_t count);
+    // Combine with a histogram over a different part of the column
+    void merge(const Histogram& other);
+
+    bool enabled() const { return !bins_.empty(); }
+    std::uint64_t count() const { return count_; }
+    std::size_t numBins() const { return bins_.size(); }
+    // Bins are [binLow(i), binLow(i) + binWidth()); the width is 0 while
+    // every value seen is equal (they are all counted in bin 0)
+    double binLow(std::size_t i) const { return origin_ + static_cast<double>(i) * width_; }
+    double binWidth() const { return width_; }
+    std::uint64_t binCount(std::size_t i) const { return bins_[i]; }
+
+private:
+    void add(double value, std::uint64_t weight);
+    void cover(double low, double high, double minWidth);
+
+    std::vector<std::uint64_t> bins_;
+    std::uint64_t count_;
+    double origin_;
+    double width_;
+};
+
+/**
+ * Everything reported about one column: moments plus the optional
+ * quantile sketch and histogram, all filled in the same pass
+ */
+class ColumnSummary {
+public:
+    /**
+     * @param sketchSize: accuracy parameter of the quantile sketch (0 disables it)
+     * @param histogramBins: number of histogram bins (0 disables it)
+     */
+    explicit ColumnSummary(std::size_t sketchSize = 0, std::size_t histogramBins = 0);
+
+    // Add `count` contiguous values
+    void add(const double* values, std::size_t count);
+    // Combine with a summary over a different part of the column
+    void merge(const ColumnSummary& other);
+
+    const RunningStats& stats() const { return stats_; }
+    const QuantileSketch& quantiles() const { return quantiles_; }
+    const Histogram& histogram() const { return histogram_; }
+
+private:
+    RunningStats stats_;
+    QuantileSketch quantiles_;
+    Histogram histogram_;
+};
+
+/**
+ * Summarize a column held in memory on several threads
+ * Each thread summarizes a contiguous chunk; the chunk summaries are
+ * merged in order.
+ * @param data: column values
+ * @param count: number of values
+ * @param numThreads: number of worker threads (0 means one per core)
+ * @param sketchSize: accuracy parameter of the quantile sketch (0 disables it)
+ * @param histogramBins: number of histogram bins (0 disables it)
+ * @return summary of the whole column
+ */
+ColumnSummary summarizeColumn(const double* data, std::size_t count, unsigned numThreads,
+                              std::size_t sketchSize, std::size_t histogramBins);
+
+#endif
@@ -0,0 +1,270 @@
+#include "stat_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define STAT_KERNELS_X86 1
+#include <immintrin.h>
+#endif
+
+double ColumnMoments::mean() const {
+    if (count == 0) return 0.0;
+    return shift + sum / static_cast<double>(count);
+}
+
+double ColumnMoments::variance() const {
+    if (count <= 1) return 0.0;
+    double n = static_cast<double>(count);
+    double m2 = sumSquares - sum * sum / n;
+    return m2 > 0.0 ? m2 / (n - 1.0) : 0.0;
+}
+
+static ColumnMoments emptyMoments(const double* data, std::size_t count) {
+    ColumnMoments m;
+    m.count = count;
+    m.shift = count > 0 ? data[0] : 0.0;
+    m.sum = 0.0;
+    m.sumSquares = 0.0;
+    m.min = std::numeric_limits<double>::infinity();
+    m.max = -std::numeric_limits<double>::infinity();
+    return m;
+}
+
+// Fold the values in [begin, count) into `m` one at a time
+static void momentsTail(const double* data, std::size_t begin, std::size_t count, ColumnMoments& m) {
+    for (std::size_t i = begin; i < count; i++) {
+        double d = data[i] - m.shift;
+        m.sum += d;
+        m.sumSquares += d * d;
+        m.min = std::min(m.min, data[i]);
+        m.max = std::max(m.max, data[i]);
+    }
+}
+
+static void normalizeTail(const double* in, double* out, std::size_t begin, std::size_t count,
+                          double minVal, double range) {
+    for (std::size_t i = begin; i < count; i++) {
+        out[i] = (in[i] - minVal) / range;
+    }
+}
+
+static ColumnMoments momentsScalar(const double* data, std::size_t count) {
+    ColumnMoments m = emptyMoments(data, count);
+    momentsTail(data, 0, count, m);
+    return m;
+}
+
+static void normalizeScalar(const double* in, double* out, std::size_t count, double minVal, double range) {
+    normalizeTail(in, out, 0, count, minVal, range);
+}
+
+#ifdef STAT_KERNELS_X86
+
+__attribute__((target("sse2")))
+static ColumnMoments momentsSSE2(const double* data, std::size_t count) {
+    ColumnMoments m = emptyMoments(data, count);
+    __m128d shift = _mm_set1_pd(m.shift);
+    __m128d sum = _mm_setzero_pd();
+    __m128d sq = _mm_setzero_pd();
+    __m128d lo = _mm_set1_pd(m.min);
+    __m128d hi = _mm_set1_pd(m.max);
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        __m128d x = _mm_loadu_pd(data + i);
+        __m128d d = _mm_sub_pd(x, shift);
+        sum = _mm_add_pd(sum, d);
+        sq = _mm_add_pd(sq, _mm_mul_pd(d, d));
+        lo = _mm_min_pd(lo, x);
+        hi = _mm_max_pd(hi, x);
+    }
+    double s[2], q[2], l[2], h[2];
+    _mm_storeu_pd(s, sum);
+    _mm_storeu_pd(q, sq);
+    _mm_storeu_pd(l, lo);
+    _mm_storeu_pd(h, hi);
+    m.sum = s[0] + s[1];
+    m.sumSquares = q[0] + q[1];
+    m.min = std::min(l[0], l[1]);
+    m.max = std::max(h[0], h[1]);
+    momentsTail(data, i, count, m);
+    return m;
+}
+
+__attribute__((target("sse2")))
+static void normalizeSSE2(const double* in, double* out, std::size_t count, double minVal, double range) {
+    __m128d vmin = _mm_set1_pd(minVal);
+    __m128d vrange = _mm_set1_pd(range);
+    std::size_t i = 0;
+    for (; i + 2 <= count; i += 2) {
+        _mm_storeu_pd(out + i, _mm_div_pd(_mm_sub_pd(_mm_loadu_pd(in + i), vmin), vrange));
+    }
+    normalizeTail(in, out, i, count, minVal, range);
+}
+
+__attribute__((target("avx2")))
+static ColumnMoments momentsAVX2(const double* data, std::size_t count) {
+    ColumnMoments m = emptyMoments(data, count);
+    __m256d shift = _mm256_set1_pd(m.shift);
+    // Two independent accumulator sets hide the add latency
+    __m256d sum0 = _mm256_setzero_pd(), sum1 = _mm256_setzero_pd();
+    __m256d sq0 = _mm256_setzero_pd(), sq1 = _mm256_setzero_pd();
+    __m256d lo = _mm256_set1_pd(m.min);
+    __m256d hi = _mm256_set1_pd(m.max);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        __m256d x0 = _mm256_loadu_pd(data + i);
+        __m256d x1 = _mm256_loadu_pd(data + i + 4);
+        __m256d d0 = _mm256_sub_pd(x0, shift);
+        __m256d d1 = _mm256_sub_pd(x1, shift);
+        sum0 = _mm256_add_pd(sum0, d0);
+        sum1 = _mm256_add_pd(sum1, d1);
+        sq0 = _mm256_add_pd(sq0, _mm256_mul_pd(d0, d0));
+        sq1 = _mm256_add_pd(sq1, _mm256_mul_pd(d1, d1));
+        lo = _mm256_min_pd(lo, _mm256_min_pd(x0, x1));
+        hi = _mm256_max_pd(hi, _mm256_max_pd(x0, x1));
+    }
+    double s[4], q[4], l[4], h[4];
+    _mm256_storeu_pd(s, _mm256_add_pd(sum0, sum1));
+    _mm256_storeu_pd(q, _mm256_add_pd(sq0, sq1));
+    _mm256_storeu_pd(l, lo);
+    _mm256_storeu_pd(h, hi);
+    m.sum = (s[0] + s[1]) + (s[2] + s[3]);
+    m.sumSquares = (q[0] + q[1]) + (q[2] + q[3]);
+    m.min = std::min(std::min(l[0], l[1]), std::min(l[2], l[3]));
+    m.max = std::max(std::max(h[0], h[1]), std::max(h[2], h[3]));
+    momentsTail(data, i, count, m);
+    return m;
+}
+
+__attribute__((target("avx2")))
+static void normalizeAVX2(const double* in, double* out, std::size_t count, double minVal, double range) {
+    __m256d vmin = _mm256_set1_pd(minVal);
+    __m256d vrange = _mm256_set1_pd(range);
+    std::size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        _mm256_storeu_pd(out + i, _mm256_div_pd(_mm256_sub_pd(_mm256_loadu_pd(in + i), vmin), vrange));
+    }
+    normalizeTail(in, out, i, count, minVal, range);
+}
+
+// GCC's AVX-512 headers trip -Wuninitialized on their own placeholder values
+#pragma GCC diagnostic push
+#pragma GCC diagnostic ignored "-Wuninitialized"
+#pragma GCC diagnostic ignored "-Wmaybe-uninitialized"
+
+// AVX-512 implies FMA, and GCC would fuse the multiply and add below;
+// keep them separate so every kernel rounds d * d the same way
+__attribute__((target("avx512f"), optimize("fp-contract=off")))
+static ColumnMoments momentsAVX512(const double* data, std::size_t count) {
+    ColumnMoments m = emptyMoments(data, count);
+    __m512d shift = _mm512_set1_pd(m.shift);
+    __m512d sum0 = _mm512_setzero_pd(), sum1 = _mm512_setzero_pd();
+    __m512d sq0 = _mm512_setzero_pd(), sq1 = _mm512_setzero_pd();
+    __m512d lo = _mm512_set1_pd(m.min);
+    __m512d hi = _mm512_set1_pd(m.max);
+    std::size_t i = 0;
+    for (; i + 16 <= count; i += 16) {
+        __m512d x0 = _mm512_loadu_pd(data + i);
+        __m512d x1 = _mm512_loadu_pd(data + i + 8);
+        __m512d d0 = _mm512_sub_pd(x0, shift);
+        __m512d d1 = _mm512_sub_pd(x1, shift);
+        sum0 = _mm512_add_pd(sum0, d0);
+        sum1 = _mm512_add_pd(sum1, d1);
+        sq0 = _mm512_add_pd(sq0, _mm512_mul_pd(d0, d0));
+        sq1 = _mm512_add_pd(sq1, _mm512_mul_pd(d1, d1));
+        lo = _mm512_min_pd(lo, _mm512_min_pd(x0, x1));
+        hi = _mm512_max_pd(hi, _mm512_max_pd(x0, x1));
+    }
+    m.sum = _mm512_reduce_add_pd(_mm512_add_pd(sum0, sum1));
+    m.sumSquares = _mm512_reduce_add_pd(_mm512_add_pd(sq0, sq1));
+    m.min = _mm512_reduce_min_pd(lo);
+    m.max = _mm512_reduce_max_pd(hi);
+    momentsTail(data, i, count, m);
+    return m;
+}
+
+__attribute__((target("avx512f")))
+static void normalizeAVX512(const double* in, double* out, std::size_t count, double minVal, double range) {
+    __m512d vmin = _mm512_set1_pd(minVal);
+    __m512d vrange = _mm512_set1_pd(range);
+    std::size_t i = 0;
+    for (; i + 8 <= count; i += 8) {
+        _mm512_storeu_pd(out + i, _mm512_div_pd(_mm512_sub_pd(_mm512_loadu_pd(in + i), vmin), vrange));
+    }
+    normalizeTail(in, out, i, count, minVal, range);
+}
+
+#pragma GCC diagnostic pop
+
+#endif // STAT_KERNELS_X86
+
+SimdLevel detectSimdLevel() {
+#ifdef STAT_KERNELS_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx512f")) return SimdLevel::AVX512;
+    if (__builtin_cpu_supports("avx2")) return SimdLevel::AVX2;
+    if (__builtin_cpu_supports("sse2")) return SimdLevel::SSE2;
+#endif
+    return SimdLevel::Scalar;
+}
+
+const char* simdLevelName(SimdLevel level) {
+    switch (level) {
+    case SimdLevel::SSE2: return "SSE2";
+    case SimdLevel::AVX2: return "AVX2";
+    case SimdLevel::AVX512: return "AVX-512";
+    default: return "scalar";
+    }
+}
+
+// Detected once, on first use
+static SimdLevel bestLevel() {
+    static const SimdLevel level = detectSimdLevel();
+    return level;
+}
+
+ColumnMoments computeMoments(const double* data, std::size_t count) {
+    return computeMoments(data, count, bestLevel());
+}
+
+ColumnMoments computeMoments(const double* data, std::size_t count, SimdLevel level) {
+    switch (level) {
+#ifdef STAT_KERNELS_X86
+    case SimdLevel::AVX512: return momentsAVX512(data, count);
+    case SimdLevel::AVX2: return momentsAVX2(data, count);
+    case SimdLevel::SSE2: return momentsSSE2(data, count);
+#endif
+    default: return momentsScalar(data, count);
+    }
+}
+
+void normalizeRange(const double* in, double* out, std::size_t count, double minVal, double maxVal) {
+    normalizeRange(in, out, count, minVal, maxVal, bestLevel());
+}
+
+void normalizeRange(const double* in, double* out, std::size_t count, double minVal, double maxVal,
+                    SimdLevel level) {
+    if (maxVal == minVal) {
+        std::fill(out, out + count, 0.5);
+        return;
+    }
+    scaleRange(in, out, count, minVal, maxVal - minVal, level);
+}
+
+void scaleRange(const double* in, double* out, std::size_t count, double center, double spread) {
+    scaleRange(in, out, count, center, spread, bestLevel());
+}
+
+void scaleRange(const double* in, double* out, std::size_t count, double center, double spread,
+                SimdLevel level) {
+    switch (level) {
+#ifdef STAT_KERNELS_X86
+    case SimdLevel::AVX512: normalizeAVX512(in, out, count, center, spread); break;
+    case SimdLevel::AVX2: normalizeAVX2(in, out, count, center, spread); break;
+    case SimdLevel::SSE2: normalizeSSE2(in, out, count, center, spread); break;
+#endif
+    default: normalizeScalar(in, out, count, center, spread); break;
+    }
+}
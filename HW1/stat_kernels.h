@@ -0,0 +1,74 @@
+#ifndef STAT_KERNELS_H
+#define STAT_KERNELS_H
+
+#include <cstddef>
+
+// Instruction sets the kernels are compiled for, in increasing order
+enum class SimdLevel { Scalar, SSE2, AVX2, AVX512 };
+
+/**
+ * Sums, min and max of a column, collected in one pass
+ * The sums are taken around `shift` (the first value) so that the
+ * variance does not suffer from cancellation when the mean is large
+ * compared to the spread.
+ */
+struct ColumnMoments {
+    std::size_t count;
+    double shift;
+    double sum;        // sum of (x - shift)
+    double sumSquares; // sum of (x - shift)^2
+    double min;
+    double max;
+
+    double mean() const;
+    // Sample variance (n - 1 in the denominator), 0 for fewer than two values
+    double variance() const;
+};
+
+/**
+ * Best instruction set supported by the CPU running the program
+ * @return detected level (Scalar on non-x86 builds)
+ */
+SimdLevel detectSimdLevel();
+const char* simdLevelName(SimdLevel level);
+
+/**
+ * Fused sum, sum of squares, min and max in a single pass
+ * @param data: values to reduce
+ * @param count: number of values
+ * @param level: instruction set to use; must be supported by the CPU
+ * @return moments of the values
+ */
+ColumnMoments computeMoments(const double* data, std::size_t count);
+ColumnMoments computeMoments(const double* data, std::size_t count, SimdLevel level);
+
+/**
+ * Min-max scaling out[i] = (in[i] - minVal) / (maxVal - minVal)
+ * `out` may alias `in`. Every value becomes 0.5 if maxVal == minVal.
+ * @param in: values to scale
+ * @param out: destination, at least `count` values
+ * @param count: number of values
+ * @param minVal: value mapped to 0
+ * @param maxVal: value mapped to 1
+ * @param level: instruction set to use; must be supported by the CPU
+ */
+void normalizeRange(const double* in, double* out, std::size_t count, double minVal, double maxVal);
+void normalizeRange(const double* in, double* out, std::size_t count, double minVal, double maxVal,
+                    SimdLevel level);
+
+/**
+ * Affine scaling out[i] = (in[i] - center) / spread, the kernel behind
+ * normalizeRange() for any center and spread
+ * `out` may alias `in`.
+ * @param in: values to scale
+ * @param out: destination, at least `count` values
+ * @param count: number of values
+ * @param center: value mapped to 0
+ * @param spread: distance mapped to 1; must not be 0
+ * @param level: instruction set to use; must be supported by the CPU
+ */
+void scaleRange(const double* in, double* out, std::size_t count, double center, double spread);
+void scaleRange(const double* in, double* out, std::size_t count, double center, double spread,
+                SimdLevel level);
+
+#endif
@@ -0,0 +1,109 @@
+#include "statistics.h"
+#include "stat_kernels.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+// Scalar reference implementations; the fused kernels in stat_kernels.h
+// compute the same quantities in fewer passes
+double calculateMean(const std::vector<double>& data) {
+    if (data.empty()) return 0.0;
+    
+    double sum = 0.0;
+    for (double value : data) {
+        sum += value;
+    }
+    return sum / data.size();
+}
+
+double calculateStdDev(const std::vector<double>& data, double mean) {
+    if (data.size() <= 1) return 0.0;
+    
+    double sumSquaredDiff = 0.0;
+    for (double value : data) {
+        double diff = value - mean;
+        sumSquaredDiff += diff * diff;
+    }
+    
+    return std::sqrt(sumSquaredDiff / (data.size() - 1));
+}
+
+std::vector<double> normalizeData(const std::vector<double>& data) {
+    if (data.empty()) return data;
+    
+    double minVal = *std::min_element(data.begin(), data.end());
+    double maxVal = *std::max_element(data.begin(), data.end());
+    
+    if (maxVal == minVal) {
+        // All values are the same, set to 0.5
+        return std::vector<double>(data.size(), 0.5);
+    }
+    
+    std::vector<double> normalized;
+    normalized.reserve(data.size());
+    for (double value : data) {
+        double normalizedValue = (value - minVal) / (maxVal - minVal);
+        normalized.push_back(normalizedValue);
+    }
+    
+    return normalized;
+}
+
+RunningStats::RunningStats()
+    : count_(0), mean_(0.0), m2_(0.0),
+      min_(std::numeric_limits<double>::infinity()),
+      max_(-std::numeric_limits<double>::infinity()) {}
+
+RunningStats::RunningStats(std::size_t count, double mean, double m2, double min, double max)
+    : count_(count), mean_(mean), m2_(m2), min_(min), max_(max) {}
+
+void RunningStats::add(double value) {
+    count_++;
+    double delta = value - mean_;
+    mean_ += delta / static_cast<double>(count_);
+    m2_ += delta * (value - mean_);
+    if (value < min_) min_ = value;
+    if (value > max_) max_ = value;
+}
+
+void RunningStats::add(const double* values, std::size_t count) {
+    if (count == 0) {
+        return;
+    }
+    // Reduce the block with the fused kernel, then merge it in
+    ColumnMoments moments = computeMoments(values, count);
+    RunningStats block;
+    block.count_ = count;
+    block.mean_ = moments.mean();
+    block.m2_ = std::max(0.0, moments.sumSquares - moments.sum * moments.sum / static_cast<double>(count));
+    block.min_ = moments.min;
+    block.max_ = moments.max;
+    merge(block);
+}
+
+void RunningStats::merge(const RunningStats& other) {
+    if (other.count_ == 0) {
+        return;
+    }
+    if (count_ == 0) {
+        *this = other;
+        return;
+    }
+    double total = static_cast<double>(count_ + other.count_);
+    double delta = other.mean_ - mean_;
+    mean_ += delta * static_cast<double>(other.count_) / total;
+    m2_ += other.m2_ + delta * delta * static_cast<double>(count_) * static_cast<double>(other.count_) / total;
+    count_ += other.count_;
+    if (other.min_ < min_) min_ = other.min_;
+    if (other.max_ > max_) max_ = other.max_;
+}
+
+double RunningStats::variance() const {
+    if (count_ <= 1) return 0.0;
+    return m2_ / static_cast<double>(count_ - 1);
+}
+
+double RunningStats::stdDev() const {
+    return std::sqrt(variance());
+}
@@ -0,0 +1,66 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <cstddef>
+#include <vector>
+
+/**
+ * Function to calculate mean of data
+ * @param data: vector of data values
+ * @return mean value
+ */
+double calculateMean(const std::vector<double>& data);
+
+/**
+ * Function to calculate standard deviation of data
+ * @param data: vector of data values
+ * @param mean: mean value of the data
+ * @return standard deviation
+ */
+double calculateStdDev(const std::vector<double>& data, double mean);
+
+/**
+ * Function to normalize data to range [0, 1]
+ * @param data: vector of data values
+ * @return vector of normalized values
+ */
+std::vector<double> normalizeData(const std::vector<double>& data);
+
+/**
+ * One-pass accumulator for count, mean, variance, min and max.
+ * Values are folded in with Welford's update, so nothing but the
+ * accumulator itself is kept in memory. Two accumulators over disjoint
+ * parts of a column can be merged (Chan et al.).
+ */
+class RunningStats {
+public:
+    RunningStats();
+    // Restore a saved accumulator (see m2())
+    RunningStats(std::size_t count, double mean, double m2, double min, double max);
+
+    // Add one value
+    void add(double value);
+    // Add `count` contiguous values
+    void add(const double* values, std::size_t count);
+    // Combine with an accumulator over a different part of the column
+    void merge(const RunningStats& other);
+
+    std::size_t count() const { return count_; }
+    double mean() const { return count_ == 0 ? 0.0 : mean_; }
+    // Sample variance (n - 1 in the denominator), 0 for fewer than two values
+    double variance() const;
+    double stdDev() const;
+    // Sum of squared deviations from the mean
+    double m2() const { return m2_; }
+    double min() const { return min_; }
+    double max() const { return max_; }
+
+private:
+    std::size_t count_;
+    double mean_;
+    double m2_;
+    double min_;
+    double max_;
+};
+
+#endif
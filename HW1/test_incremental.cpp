@@ -0,0 +1,124 @@
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "append_state.h"
+
+/*
+Checks of the incremental mode of data_processor.x (build it first, or use
+`make test`). Each test writes a data file and a parameter file, runs the
+processor on them and compares the saved state and the result file with
+what a full run over the final data file gives.
+*/
+
+static const char* dataFile = "test_incremental.csv";
+static const char* paramFile = "test_incremental_params.txt";
+static const char* outputFile = "test_incremental_normalized.txt";
+
+/**
+ * Function to write or append text to a file
+ * @param filename: name of the file
+ * @param text: text to write
+ * @param append: true to append, false to replace the file
+ */
+void writeText(const std::string& filename, const std::string& text, bool append) {
+    std::ofstream file(filename, append ? std::ios::binary | std::ios::app : std::ios::binary);
+    file << text;
+    assert(file);
+}
+
+/**
+ * Function to run data_processor.x incrementally on column 0 of the data file
+ */
+void runIncremental() {
+    writeText(paramFile, std::string("data_file = ") + dataFile + "\nnum_lines = 0\ncolumn = 0\nincremental = 1\n",
+              false);
+    int status = std::system((std::string("./data_processor.x ") + paramFile + " > test_incremental.log").c_str());
+    assert(status == 0);
+}
+
+/**
+ * Function to read the normalized values of the result file
+ * @return values after the "Normalized data:" line
+ */
+std::vector<double> readOutput() {
+    std::ifstream file(outputFile);
+    std::string line;
+    while (std::getline(file, line) && line != "Normalized data:") {
+    }
+    std::vector<double> values;
+    double value;
+    while (file >> value) {
+        values.push_back(value);
+    }
+    return values;
+}
+
+/**
+ * Function to check the state and result file against the expected column
+ * @param column: every value of column 0 in the data file
+ */
+void checkColumn(const std::vector<double>& column) {
+    AppendState state;
+    assert(loadAppendState(appendStateName(outputFile), state));
+    double sum = 0.0;
+    double minVal = column[0], maxVal = column[0];
+    for (double x : column) {
+        sum += x;
+        minVal = std::min(minVal, x);
+        maxVal = std::max(maxVal, x);
+    }
+    assert(state.stats.count() == column.size());
+    assert(std::abs(state.stats.mean() - sum / column.size()) < 1e-12);
+    assert(state.stats.min() == minVal && state.stats.max() == maxVal);
+    
+    std::vector<double> values = readOutput();
+    assert(values.size() == column.size());
+    for (std::size_t i = 0; i < column.size(); i++) {
+        assert(std::abs(values[i] - (column[i] - minVal) / (maxVal - minVal)) <= 0.005);
+    }
+}
+
+// Rows appended to a file that already holds a state
+void testAppend() {
+    writeText(dataFile, "a,b\n1,2\n10,3\n", false);
+    runIncremental();
+    checkColumn({1, 10});
+    writeText(dataFile, "4,5\n7,8\n", true);
+    runIncremental();
+    checkColumn({1, 10, 4, 7});
+    std::cout << "==> testAppend passed" << std::endl;
+}
+
+// The first run sees half of the last row; the rest of it is appended later
+void testAppendPartialLine() {
+    writeText(dataFile, "a,b\n1,2\n10,3\n5", false);
+    runIncremental();
+    checkColumn({1, 10, 5});
+    writeText(dataFile, "3,4\n", true);
+    runIncremental();
+    checkColumn({1, 10, 53});
+    writeText(dataFile, "2,1\n", true);
+    runIncremental();
+    checkColumn({1, 10, 53, 2});
+    std::cout << "==> testAppendPartialLine passed" << std::endl;
+}
+
+int main() {
+    testAppend();
+    testAppendPartialLine();
+    
+    std::remove(dataFile);
+    std::remove(paramFile);
+    std::remove(outputFile);
+    std::remove(appendStateName(outputFile).c_str());
+    std::remove("test_incremental.log");
+    std::cout << "=== ALL TESTS PASSED ===" << std::endl;
+    return 0;
+}
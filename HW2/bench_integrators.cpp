@@ -0,0 +1,179 @@
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "integrators.h"
+
+using namespace std;
+
+// Accuracy versus cost of the integrators on the sin(t + i) forcing.
+// With x'' = sin(t + i) / m the exact solution is
+//   v_i(t) = v_i(0) + (cos(i) - cos(t + i)) / m
+//   x_i(t) = x_i(0) + v_i(0) t + (t cos(i) - sin(t + i) + sin(i)) / m
+// Every integrator runs N random particles to time T; the fixed-step ones
+// over a range of dt, the adaptive one over a range of tolerances, stopping
+// every R time units to report.
+
+struct Run {
+	string integrator;
+	string setting;      // "dt=..." or "rtol=..."
+	size_t steps;
+	size_t evaluations;  // force evaluations over the whole system
+	double seconds;
+	double positionError; // largest |x - exact| at T
+	double velocityError;
+};
+
+ParticleSystem makeParticles(size_t count, int dimension, unsigned seed)
+{
+	mt19937 gen(seed);
+	uniform_real_distribution<double> dis(-1.0, 1.0);
+	uniform_real_distribution<double> mass(0.5, 2.0);
+	ParticleSystem system(dimension, count);
+	for (size_t n = 0; n < count; ++n) {
+		size_t i = system.add(mass(gen));
+		for (int c = 0; c < dimension; ++c) {
+			system.position(c)[i] = dis(gen);
+			system.velocity(c)[i] = dis(gen);
+		}
+	}
+	return system;
+}
+
+// Largest position and velocity errors against the exact solution at T
+void measureErrors(const ParticleSystem& start, const ParticleSystem& end, double T, Run& run)
+{
+	run.positionError = 0.0;
+	run.velocityError = 0.0;
+	for (int c = 0; c < start.dimension(); ++c) {
+		const double ci = static_cast<double>(c);
+		for (size_t i = 0; i < start.size(); ++i) {
+			const double m = start.mass(i);
+			const double x0 = start.position(c)[i];
+			const double v0 = start.velocity(c)[i];
+			const double x = x0 + v0 * T + (T * std::cos(ci) - std::sin(T + ci) + std::sin(ci)) / m;
+			const double v = v0 + (std::cos(ci) - std::cos(T + ci)) / m;
+			run.positionError = std::max(run.positionError, std::fabs(end.position(c)[i] - x));
+			run.velocityError = std::max(run.velocityError, std::fabs(end.velocity(c)[i] - v));
+		}
+	}
+}
+
+// Advance a copy of `start` to T in `intervals` calls of advance()
+Run integrate(Integrator& integrator, const ParticleSystem& start, double T, size_t intervals, const string& setting)
+{
+	ParticleSystem system = start;
+	const double dt = T / static_cast<double>(intervals);
+	auto begin = chrono::steady_clock::now();
+	for (size_t k = 0; k < intervals; ++k) {
+		integrator.advance(system, static_cast<double>(k) * dt, dt);
+	}
+	Run run;
+	run.seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+	run.integrator = integrator.name();
+	run.setting = setting;
+	run.steps = intervals;
+	run.evaluations = integrator.forceEvaluations();
+	measureErrors(start, system, T, run);
+	return run;
+}
+
+int main(int argc, char** argv)
+{
+	size_t count = 1000;
+	int dimension = 3;
+	double T = 10.0;
+	double report = 1.0;
+	string csvFile;
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		if (arg == "--particles" && i + 1 < argc) {
+			count = static_cast<size_t>(stod(argv[++i]));
+		}
+		else if (arg == "--dim" && i + 1 < argc) {
+			dimension = stoi(argv[++i]);
+		}
+		else if (arg == "--time" && i + 1 < argc) {
+			T = stod(argv[++i]);
+		}
+		else if (arg == "--report" && i + 1 < argc) {
+			report = stod(argv[++i]);
+		}
+		else if (arg == "--csv" && i + 1 < argc) {
+			csvFile = argv[++i];
+		}
+		else {
+			cerr << "Usage: " << argv[0] << " [--particles N] [--dim D] [--time T] [--report R] [--csv FILE]" << endl;
+			return 1;
+		}
+	}
+
+	const ParticleSystem start = makeParticles(count, dimension, 12345);
+	vector<Run> runs;
+	const double steps[] = { 0.2, 0.1, 0.05, 0.02, 0.01, 0.005, 0.002, 0.001 };
+	for (const char* type : { "euler", "verlet", "rk4" }) {
+		for (double dt : steps) {
+			auto integrator = makeIntegrator(type);
+			const size_t intervals = static_cast<size_t>(std::llround(T / dt));
+			runs.push_back(integrate(*integrator, start, T, intervals, "dt=" + to_string(dt).substr(0, 5)));
+		}
+	}
+	// The adaptive integrator chooses its own steps between reports
+	const size_t reports = std::max<size_t>(1, static_cast<size_t>(std::llround(T / report)));
+	for (int exponent = 3; exponent <= 11; exponent += 2) {
+		const double rtol = std::pow(10.0, -exponent);
+		DormandPrinceIntegrator integrator(rtol, rtol * 1e-3);
+		Run run = integrate(integrator, start, T, reports, "rtol=1e-" + to_string(exponent));
+		run.steps = integrator.acceptedSteps() + integrator.rejectedSteps();
+		runs.push_back(run);
+	}
+
+	cout << count << " particles, " << dimension << "D, T = " << T << endl;
+	cout << left << setw(8) << "method" << setw(12) << "setting" << right << setw(8) << "steps"
+		<< setw(10) << "forces" << setw(12) << "ns/p-step" << setw(14) << "max |dx|" << setw(14) << "max |dv|" << endl;
+	for (const Run& run : runs) {
+		cout << left << setw(8) << run.integrator << setw(12) << run.setting << right << setw(8) << run.steps
+			<< setw(10) << run.evaluations << setw(12) << fixed << setprecision(1)
+			<< run.seconds * 1e9 / (static_cast<double>(run.steps) * count) << scientific << setprecision(2)
+			<< setw(14) << run.positionError << setw(14) << run.velocityError << defaultfloat << endl;
+	}
+
+	// Cheapest setting of each integrator that reaches a target error
+	cout << endl << "Force evaluations needed for a position error below:" << endl;
+	cout << left << setw(8) << "method" << right;
+	const double targets[] = { 1e-2, 1e-4, 1e-6, 1e-8 };
+	for (double target : targets) {
+		cout << setw(12) << target;
+	}
+	cout << endl;
+	for (const char* type : { "euler", "verlet", "rk4", "rk45" }) {
+		cout << left << setw(8) << type << right;
+		for (double target : targets) {
+			size_t best = 0;
+			for (const Run& run : runs) {
+				if (run.integrator == type && run.positionError <= target && (best == 0 || run.evaluations < best)) {
+					best = run.evaluations;
+				}
+			}
+			cout << setw(12) << (best == 0 ? string("-") : to_string(best));
+		}
+		cout << endl;
+	}
+
+	if (!csvFile.empty()) {
+		ofstream csv(csvFile);
+		csv << "integrator,setting,steps,force_evaluations,seconds,position_error,velocity_error\n";
+		csv << setprecision(9);
+		for (const Run& run : runs) {
+			csv << run.integrator << "," << run.setting << "," << run.steps << "," << run.evaluations << ","
+				<< run.seconds << "," << run.positionError << "," << run.velocityError << "\n";
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,171 @@
+#include <chrono>
+#include <cmath>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "nbody.h"
+#include "particle_system.h"
+
+using namespace std;
+
+// Cost of one pairwise force evaluation with each strategy, for growing N:
+// gravity (brute force against Barnes-Hut) on particles spread uniformly in
+// a unit cube, and Lennard-Jones with a 2.5 sigma cutoff (brute force
+// against cell lists) at a fixed density of 0.5 particles per sigma^D.
+// Brute force stops once one evaluation takes longer than the time budget.
+
+struct Timing {
+	string force;
+	int dimension;
+	size_t count;
+	string method;
+	double seconds;       // per evaluation
+	double relativeError; // RMS force error against brute force (-1 if not measured)
+};
+
+ParticleSystem makeParticles(size_t count, int dimension, double side, unsigned seed)
+{
+	mt19937 gen(seed);
+	uniform_real_distribution<double> dis(0.0, side);
+	uniform_real_distribution<double> mass(0.5, 1.5);
+	ParticleSystem system(dimension, count);
+	for (size_t n = 0; n < count; ++n) {
+		size_t i = system.add(mass(gen));
+		for (int c = 0; c < dimension; ++c) {
+			system.position(c)[i] = dis(gen);
+		}
+	}
+	return system;
+}
+
+// Mean time of one force evaluation, repeated for at least 0.2 s
+double timeForces(ParticleSystem& system)
+{
+	system.computeForces(0.0); // warm up the kernel's scratch arrays
+	int repeats = 0;
+	auto begin = chrono::steady_clock::now();
+	double elapsed = 0.0;
+	do {
+		system.computeForces(0.0);
+		++repeats;
+		elapsed = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+	} while (elapsed < 0.2 && repeats < 1000);
+	return elapsed / repeats;
+}
+
+double relativeError(const ParticleSystem& system, const ParticleSystem& exact)
+{
+	double difference = 0.0;
+	double norm = 0.0;
+	for (int c = 0; c < system.dimension(); ++c) {
+		for (size_t i = 0; i < system.size(); ++i) {
+			const double d = system.force(c)[i] - exact.force(c)[i];
+			difference += d * d;
+			norm += exact.force(c)[i] * exact.force(c)[i];
+		}
+	}
+	return norm > 0.0 ? std::sqrt(difference / norm) : 0.0;
+}
+
+int main(int argc, char** argv)
+{
+	size_t maxCount = 65536;
+	unsigned numThreads = 0;
+	double theta = 0.5;
+	double budget = 2.0;
+	string csvFile;
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		if (arg == "--max-n" && i + 1 < argc) {
+			maxCount = static_cast<size_t>(stod(argv[++i]));
+		}
+		else if (arg == "--threads" && i + 1 < argc) {
+			numThreads = static_cast<unsigned>(stoul(argv[++i]));
+		}
+		else if (arg == "--theta" && i + 1 < argc) {
+			theta = stod(argv[++i]);
+		}
+		else if (arg == "--budget" && i + 1 < argc) {
+			budget = stod(argv[++i]);
+		}
+		else if (arg == "--csv" && i + 1 < argc) {
+			csvFile = argv[++i];
+		}
+		else {
+			cerr << "Usage: " << argv[0] << " [--max-n N] [--threads T] [--theta THETA] [--budget SECONDS] [--csv FILE]"
+				<< endl;
+			return 1;
+		}
+	}
+
+	vector<Timing> timings;
+	for (int gravity = 1; gravity >= 0; --gravity) {
+		const string force = gravity ? "gravity" : "lennard-jones";
+		const string fastName = gravity ? "barnes-hut" : "cell-list";
+		for (int dimension = 2; dimension <= 3; ++dimension) {
+			cout << endl << force << ", " << dimension << "D" << endl;
+			cout << setw(9) << "N" << setw(14) << "brute (ms)" << setw(16) << (fastName + " (ms)")
+				<< setw(10) << "speedup" << setw(12) << "rel error" << endl;
+			bool bruteForce = true;
+			size_t crossover = 0;
+			for (size_t count = 128; count <= maxCount; count *= 2) {
+				const double side = gravity ? 1.0 : std::pow(count / 0.5, 1.0 / dimension);
+				const ParticleSystem start = makeParticles(count, dimension, side, 7);
+				ParticleSystem fast = start;
+				fast.setForce(gravity
+					? ForceKernel(PairForce::gravity(1.0, 1e-3, PairMethod::BarnesHut, theta, numThreads))
+					: ForceKernel(PairForce::lennardJones(1.0, 1.0, 2.5, PairMethod::CellList, numThreads)));
+				Timing fastTiming = { force, dimension, count, fastName, timeForces(fast), -1.0 };
+
+				Timing bruteTiming = { force, dimension, count, "brute-force", -1.0, -1.0 };
+				if (bruteForce) {
+					ParticleSystem brute = start;
+					brute.setForce(gravity
+						? ForceKernel(PairForce::gravity(1.0, 1e-3, PairMethod::BruteForce, theta, numThreads))
+						: ForceKernel(PairForce::lennardJones(1.0, 1.0, 2.5, PairMethod::BruteForce, numThreads)));
+					bruteTiming.seconds = timeForces(brute);
+					fastTiming.relativeError = relativeError(fast, brute);
+					timings.push_back(bruteTiming);
+					// The next size costs about four times as much
+					bruteForce = 4.0 * bruteTiming.seconds < budget;
+					if (crossover == 0 && fastTiming.seconds < bruteTiming.seconds) {
+						crossover = count;
+					}
+				}
+				timings.push_back(fastTiming);
+
+				cout << setw(9) << count << fixed << setprecision(3);
+				if (bruteTiming.seconds >= 0.0) {
+					cout << setw(14) << bruteTiming.seconds * 1e3 << setw(16) << fastTiming.seconds * 1e3
+						<< setprecision(1) << setw(10) << bruteTiming.seconds / fastTiming.seconds
+						<< scientific << setprecision(1) << setw(12) << fastTiming.relativeError;
+				}
+				else {
+					cout << setw(14) << "-" << setw(16) << fastTiming.seconds * 1e3;
+				}
+				cout << defaultfloat << endl;
+			}
+			if (crossover > 0) {
+				cout << fastName << " is faster from N = " << crossover << endl;
+			}
+			else {
+				cout << fastName << " was not faster in the sizes where brute force ran" << endl;
+			}
+		}
+	}
+
+	if (!csvFile.empty()) {
+		ofstream csv(csvFile);
+		csv << "force,dimension,particles,method,seconds,relative_error\n";
+		csv << setprecision(9);
+		for (const Timing& t : timings) {
+			csv << t.force << "," << t.dimension << "," << t.count << "," << t.method << "," << t.seconds << ","
+				<< t.relativeError << "\n";
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,133 @@
+#include <chrono>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <string>
+#include <vector>
+
+#include "homework2_skeleton.cpp"
+
+using namespace std;
+
+// Norms of many vectors and distances between many points: one Vector at a
+// time through the string-selected norm, against the batched kernels of
+// norms.h on packed and structure-of-arrays data.
+
+// Mean time of f() over at least 0.2 s
+template <typename F>
+double timeIt(F f)
+{
+	f();
+	int repeats = 0;
+	auto begin = chrono::steady_clock::now();
+	double elapsed = 0.0;
+	do {
+		f();
+		++repeats;
+		elapsed = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+	} while (elapsed < 0.2);
+	return elapsed / repeats;
+}
+
+template <NormType T>
+void benchNorm(const string& name, const vector<Vector>& vectors, const vector<double>& packed,
+	const vector<const double*>& columns, int dimension, size_t points)
+{
+	const size_t count = vectors.size();
+	vector<double> out(count);
+	double sink = 0.0;
+	const double perString = timeIt([&]() {
+		for (size_t i = 0; i < count; ++i) {
+			out[i] = vectors[i].norm(vectors[i], name);
+		}
+	});
+	const double perVector = timeIt([&]() {
+		for (size_t i = 0; i < count; ++i) {
+			out[i] = vectorNorm<T>(packed.data() + i * dimension, dimension);
+		}
+	});
+	const double perPacked = timeIt([&]() { batchNorms<T>(packed.data(), dimension, count, out.data()); });
+	const double perColumns = timeIt([&]() { batchNorms<T>(columns.data(), dimension, count, out.data()); });
+	sink += out[count / 2];
+
+	// Distances among the first `points` vectors
+	vector<double> distances(points * points);
+	const double pairString = timeIt([&]() {
+		for (size_t i = 0; i < points; ++i) {
+			for (size_t j = 0; j < points; ++j) {
+				const Vector d = vectors[j] - vectors[i];
+				distances[i * points + j] = d.norm(d, name);
+			}
+		}
+	});
+	const double pairPacked = timeIt([&]() {
+		pairwiseDistances<T>(packed.data(), points, packed.data(), points, dimension, distances.data());
+	});
+	const double pairColumns = timeIt([&]() {
+		pairwiseDistances<T>(columns.data(), points, columns.data(), points, dimension, distances.data());
+	});
+	sink += distances[points + 1];
+
+	const double n = static_cast<double>(count);
+	const double pairs = static_cast<double>(points) * points;
+	cout << setw(6) << name << fixed << setprecision(2) << setw(10) << perString * 1e9 / n << setw(10)
+		<< perVector * 1e9 / n << setw(10) << perPacked * 1e9 / n << setw(10) << perColumns * 1e9 / n
+		<< setw(12) << pairString * 1e9 / pairs << setw(10) << pairPacked * 1e9 / pairs << setw(10)
+		<< pairColumns * 1e9 / pairs << defaultfloat << (sink == -1.0 ? " " : "") << endl;
+}
+
+int main(int argc, char** argv)
+{
+	size_t count = 1000000;
+	int dimension = 3;
+	size_t points = 2000;
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		if (arg == "--count" && i + 1 < argc) {
+			count = static_cast<size_t>(stod(argv[++i]));
+		}
+		else if (arg == "--dim" && i + 1 < argc) {
+			dimension = stoi(argv[++i]);
+		}
+		else if (arg == "--points" && i + 1 < argc) {
+			points = static_cast<size_t>(stod(argv[++i]));
+		}
+		else {
+			cerr << "Usage: " << argv[0] << " [--count N] [--dim D] [--points P]" << endl;
+			return 1;
+		}
+	}
+	if (dimension < 1 || count < 1 || points > count) {
+		cerr << "Need a positive dimension and count, and points <= count" << endl;
+		return 1;
+	}
+
+	mt19937 gen(3);
+	uniform_real_distribution<double> dis(-1.0, 1.0);
+	vector<Vector> vectors;
+	vectors.reserve(count);
+	vector<double> packed(count * dimension);
+	vector<vector<double>> columnData(dimension, vector<double>(count));
+	vector<const double*> columns(dimension);
+	for (size_t i = 0; i < count; ++i) {
+		vector<double> components(dimension);
+		for (int c = 0; c < dimension; ++c) {
+			components[c] = dis(gen);
+			packed[i * dimension + c] = components[c];
+			columnData[c][i] = components[c];
+		}
+		vectors.push_back(Vector(components));
+	}
+	for (int c = 0; c < dimension; ++c) {
+		columns[c] = columnData[c].data();
+	}
+
+	cout << count << " vectors of dimension " << dimension << "; distances among " << points << " of them" << endl;
+	cout << "ns per norm" << setw(46) << "ns per distance" << endl;
+	cout << setw(6) << "norm" << setw(10) << "string" << setw(10) << "single" << setw(10) << "packed"
+		<< setw(10) << "columns" << setw(12) << "Vector" << setw(10) << "packed" << setw(10) << "columns" << endl;
+	benchNorm<NormType::L1>("L1", vectors, packed, columns, dimension, points);
+	benchNorm<NormType::L2>("L2", vectors, packed, columns, dimension, points);
+	benchNorm<NormType::Linf>("Linf", vectors, packed, columns, dimension, points);
+	return 0;
+}
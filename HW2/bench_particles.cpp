@@ -0,0 +1,286 @@
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <new>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "integrators.h"
+
+using namespace std;
+
+// Cost of advancing particles with each representation:
+//   Particle         runtime-size Vector components, one object per particle
+//   ParticleN<N>     fixed-size components (only N = 2, 3, 6 are instantiated here)
+//   ParticleSystem   structure of arrays, stepped by any integrator
+// for every dimension, particle count and integrator asked for. Particle and
+// ParticleN step with their own update(), which is the Euler step.
+// Heap allocations are counted by replacing the global operator new.
+
+static atomic<size_t> allocations(0);
+
+void* operator new(size_t size)
+{
+	allocations.fetch_add(1, memory_order_relaxed);
+	if (void* p = malloc(size == 0 ? 1 : size)) {
+		return p;
+	}
+	throw bad_alloc();
+}
+
+void* operator new[](size_t size)
+{
+	return operator new(size);
+}
+
+void operator delete(void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p) noexcept
+{
+	free(p);
+}
+
+void operator delete(void* p, size_t) noexcept
+{
+	free(p);
+}
+
+void operator delete[](void* p, size_t) noexcept
+{
+	free(p);
+}
+
+struct Measurement {
+	string representation;
+	string integrator;
+	int dimension;
+	size_t count;
+	size_t steps;
+	double seconds;
+	size_t allocations;
+};
+
+// Particle constructors and destructors print; keep them quiet while timing
+struct QuietOutput {
+	ostringstream sink;
+	streambuf* saved;
+	QuietOutput() : saved(cout.rdbuf(sink.rdbuf())) {}
+	~QuietOutput() { cout.rdbuf(saved); }
+};
+
+// Run step(t, dt) in rounds of doubling length until at least minTime has
+// passed; allocations are counted over the timed steps only
+template <typename Step>
+void measure(Measurement& m, double minTime, Step step)
+{
+	const double dt = 1e-3;
+	step(0.0, dt); // warm up: scratch arrays, caches
+	size_t steps = 0;
+	size_t rounds = 1;
+	const size_t before = allocations.load();
+	auto begin = chrono::steady_clock::now();
+	double elapsed = 0.0;
+	while (elapsed < minTime) {
+		for (size_t k = 0; k < rounds; ++k, ++steps) {
+			step(static_cast<double>(steps) * dt, dt);
+		}
+		rounds *= 2;
+		elapsed = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+	}
+	m.seconds = elapsed;
+	m.steps = steps;
+	m.allocations = allocations.load() - before;
+}
+
+vector<double> randomComponents(mt19937& gen, int dimension)
+{
+	uniform_real_distribution<double> dis(-1.0, 1.0);
+	vector<double> components(dimension);
+	for (double& x : components) {
+		x = dis(gen);
+	}
+	return components;
+}
+
+Measurement benchParticles(int dimension, size_t count, double minTime)
+{
+	Measurement m = { "Particle", "euler", dimension, count, 0, 0.0, 0 };
+	QuietOutput quiet;
+	mt19937 gen(1);
+	vector<Particle> particles;
+	particles.reserve(count);
+	const Vector zero(vector<double>(dimension, 0.0));
+	for (size_t i = 0; i < count; ++i) {
+		particles.emplace_back(1.0, Vector(randomComponents(gen, dimension)), zero, zero);
+	}
+	measure(m, minTime, [&](double t, double dt) {
+		for (Particle& p : particles) {
+			p.update(t, dt);
+		}
+	});
+	return m;
+}
+
+template <size_t N>
+Measurement benchFixedParticles(size_t count, double minTime)
+{
+	Measurement m = { "ParticleN", "euler", static_cast<int>(N), count, 0, 0.0, 0 };
+	QuietOutput quiet;
+	mt19937 gen(1);
+	vector<ParticleN<N>> particles;
+	particles.reserve(count);
+	for (size_t i = 0; i < count; ++i) {
+		const VectorN<N> position(Vector(randomComponents(gen, N)));
+		particles.emplace_back(1.0, position, VectorN<N>(), VectorN<N>());
+	}
+	measure(m, minTime, [&](double t, double dt) {
+		for (ParticleN<N>& p : particles) {
+			p.update(t, dt);
+		}
+	});
+	return m;
+}
+
+// ParticleN only exists for the dimensions instantiated here
+bool benchFixedParticles(int dimension, size_t count, double minTime, Measurement& m)
+{
+	switch (dimension) {
+	case 2: m = benchFixedParticles<2>(count, minTime); return true;
+	case 3: m = benchFixedParticles<3>(count, minTime); return true;
+	case 6: m = benchFixedParticles<6>(count, minTime); return true;
+	default: return false;
+	}
+}
+
+Measurement benchSystem(int dimension, size_t count, const string& type, double minTime)
+{
+	Measurement m = { "ParticleSystem", type, dimension, count, 0, 0.0, 0 };
+	mt19937 gen(1);
+	ParticleSystem system(dimension, count);
+	for (size_t i = 0; i < count; ++i) {
+		system.add(1.0);
+		const vector<double> position = randomComponents(gen, dimension);
+		for (int c = 0; c < dimension; ++c) {
+			system.position(c)[i] = position[c];
+		}
+	}
+	unique_ptr<Integrator> integrator = makeIntegrator(type);
+	measure(m, minTime, [&](double t, double dt) {
+		integrator->advance(system, t, dt);
+	});
+	return m;
+}
+
+template <typename T>
+vector<T> parseList(const string& text)
+{
+	vector<T> values;
+	stringstream in(text);
+	string item;
+	while (getline(in, item, ',')) {
+		stringstream value(item);
+		double x = 0.0;
+		value >> x;
+		values.push_back(static_cast<T>(x));
+	}
+	return values;
+}
+
+vector<string> parseNames(const string& text)
+{
+	vector<string> names;
+	stringstream in(text);
+	string item;
+	while (getline(in, item, ',')) {
+		names.push_back(item);
+	}
+	return names;
+}
+
+int main(int argc, char** argv)
+{
+	vector<int> dimensions = { 2, 3, 6, 10 };
+	vector<size_t> counts = { 1, 100, 10000, 1000000 };
+	vector<string> integrators = { "euler", "verlet", "rk4", "rk45" };
+	double minTime = 0.2;
+	string csvFile;
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		if (arg == "--dims" && i + 1 < argc) {
+			dimensions = parseList<int>(argv[++i]);
+		}
+		else if (arg == "--counts" && i + 1 < argc) {
+			counts = parseList<size_t>(argv[++i]);
+		}
+		else if (arg == "--integrators" && i + 1 < argc) {
+			integrators = parseNames(argv[++i]);
+		}
+		else if (arg == "--min-time" && i + 1 < argc) {
+			minTime = stod(argv[++i]);
+		}
+		else if (arg == "--csv" && i + 1 < argc) {
+			csvFile = argv[++i];
+		}
+		else {
+			cerr << "Usage: " << argv[0] << " [--dims 2,3,6,10] [--counts 1,100,10000,1e6]"
+				<< " [--integrators euler,verlet,rk4,rk45] [--min-time SECONDS] [--csv FILE]" << endl;
+			return 1;
+		}
+	}
+	for (int dimension : dimensions) {
+		if (dimension < 1) {
+			cerr << "Dimensions must be positive" << endl;
+			return 1;
+		}
+	}
+	for (const string& type : integrators) {
+		makeIntegrator(type); // reject unknown names before any timing
+	}
+
+	vector<Measurement> results;
+	cout << left << setw(16) << "representation" << setw(8) << "method" << right << setw(5) << "dim"
+		<< setw(10) << "N" << setw(14) << "steps/s" << setw(14) << "ns/p-step" << setw(14) << "allocs/step"
+		<< endl;
+	auto print = [&](const Measurement& m) {
+		const double particleSteps = static_cast<double>(m.steps) * m.count;
+		cout << left << setw(16) << m.representation << setw(8) << m.integrator << right << setw(5) << m.dimension
+			<< setw(10) << m.count << fixed << setprecision(1) << setw(14) << m.steps / m.seconds
+			<< setw(14) << m.seconds * 1e9 / particleSteps << setprecision(2) << setw(14)
+			<< static_cast<double>(m.allocations) / m.steps << defaultfloat << endl;
+		results.push_back(m);
+	};
+	for (int dimension : dimensions) {
+		for (size_t count : counts) {
+			print(benchParticles(dimension, count, minTime));
+			Measurement fixed;
+			if (benchFixedParticles(dimension, count, minTime, fixed)) {
+				print(fixed);
+			}
+			for (const string& type : integrators) {
+				print(benchSystem(dimension, count, type, minTime));
+			}
+		}
+	}
+
+	if (!csvFile.empty()) {
+		ofstream csv(csvFile);
+		csv << "representation,integrator,dimension,particles,steps,seconds,steps_per_second,"
+			<< "ns_per_particle_step,allocations_per_step\n";
+		csv << setprecision(9);
+		for (const Measurement& m : results) {
+			csv << m.representation << "," << m.integrator << "," << m.dimension << "," << m.count << ","
+				<< m.steps << "," << m.seconds << "," << m.steps / m.seconds << ","
+				<< m.seconds * 1e9 / (static_cast<double>(m.steps) * m.count) << ","
+				<< static_cast<double>(m.allocations) / m.steps << "\n";
+		}
+	}
+	return 0;
+}
@@ -0,0 +1,405 @@
+#ifndef CHECKPOINT_H
+#define CHECKPOINT_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <mutex>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#include "integrators.h"
+#include "particle_system.h"
+
+// Binary I/O of checkpoint files (native byte order)
+template <typename T>
+inline void writeValue(std::ostream& out, const T& value)
+{
+	out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+template <typename T>
+inline void readValue(std::istream& in, T& value)
+{
+	in.read(reinterpret_cast<char*>(&value), sizeof(value));
+}
+
+inline void writeDoubles(std::ostream& out, const vector<double>& values)
+{
+	out.write(reinterpret_cast<const char*>(values.data()),
+		static_cast<std::streamsize>(values.size() * sizeof(double)));
+}
+
+// Bytes from the read position to the end of the stream (unlimited if
+// the stream cannot seek)
+inline std::uint64_t bytesLeft(std::istream& in)
+{
+	const std::istream::pos_type position = in.tellg();
+	if (position == std::istream::pos_type(-1)) {
+		return UINT64_MAX;
+	}
+	in.seekg(0, std::ios::end);
+	const std::istream::pos_type end = in.tellg();
+	in.seekg(position);
+	return end == std::istream::pos_type(-1) ? UINT64_MAX : static_cast<std::uint64_t>(end - position);
+}
+
+inline void readDoubles(std::istream& in, vector<double>& values, std::uint64_t count)
+{
+	if (in && count > bytesLeft(in) / sizeof(double)) {
+		throw std::invalid_argument("Corrupt checkpoint file");
+	}
+	values.resize(in ? static_cast<size_t>(count) : 0);
+	in.read(reinterpret_cast<char*>(values.data()),
+		static_cast<std::streamsize>(values.size() * sizeof(double)));
+}
+
+// Write `filename` with write(out) through a temporary file, so a crash
+// while writing leaves the previous file intact
+template <typename Write>
+void replaceFile(const string& filename, Write write)
+{
+	const string temporary = filename + ".tmp";
+	{
+		std::ofstream out(temporary, std::ios::binary);
+		write(out);
+		out.flush();
+		if (!out) {
+			throw std::runtime_error("Failed to write checkpoint " + temporary);
+		}
+	}
+	// Replaces an existing file, unlike std::rename on Windows
+	std::error_code ec;
+	std::filesystem::rename(temporary, filename, ec);
+	if (ec) {
+		std::remove(temporary.c_str());
+		throw std::runtime_error("Failed to replace checkpoint " + filename);
+	}
+}
+
+// Full state of a run after some step: time, time step, every particle's
+// mass, position, velocity and force, the integrator's carried-over state
+// and the state of any random engines and distributions.
+// Checkpoint file (native byte order):
+//   magic "HW2CKPT\0" (8 bytes), uint32 version, uint32 dimension,
+//   uint64 particles, uint64 step, double t, double dt,
+//   doubles: masses, then positions, velocities and forces component by
+//   component (all particles of component 0, then component 1, ...),
+//   uint64 count + doubles: integrator state,
+//   uint64 length + bytes: random states as text (operator<< of the engines)
+class Checkpoint
+{
+public:
+	static const char* magic() { return "HW2CKPT"; }
+	static const std::uint32_t version = 1;
+
+	size_t step = 0;
+	double t = 0.0;
+	double dt = 0.0;
+
+	int dimension() const { return dimension_; }
+	size_t particles() const { return mass_.size(); }
+
+	// Copy the state of `system` (and of `integrator`, if any) after `step` steps
+	void capture(size_t step, double t, double dt, const ParticleSystem& system,
+		const Integrator* integrator = nullptr)
+	{
+		this->step = step;
+		this->t = t;
+		this->dt = dt;
+		dimension_ = system.dimension();
+		const size_t n = system.size();
+		mass_.assign(system.masses(), system.masses() + n);
+		position_.resize(dimension_ * n);
+		velocity_.resize(dimension_ * n);
+		force_.resize(dimension_ * n);
+		for (int c = 0; c < dimension_; ++c) {
+			std::copy(system.position(c), system.position(c) + n, position_.begin() + c * n);
+			std::copy(system.velocity(c), system.velocity(c) + n, velocity_.begin() + c * n);
+			std::copy(system.force(c), system.force(c) + n, force_.begin() + c * n);
+		}
+		if (integrator != nullptr) {
+			integrator_ = integrator->saveState(system, t);
+		}
+		else {
+			integrator_.clear();
+		}
+		random_.clear();
+	}
+
+	// Save random engines and distributions (their exact state, as operator<< writes it)
+	template <typename... Random>
+	void captureRandom(const Random&... random)
+	{
+		std::ostringstream out;
+		int expand[] = { 0, (out << random << '\n', 0)... };
+		(void)expand;
+		random_ = out.str();
+	}
+
+	// Put the particles back into `system`, which must have the same dimension
+	// and either no particles or as many as were saved. Force kernels are not
+	// part of the state: set them up as in the original run.
+	void restore(ParticleSystem& system, Integrator* integrator = nullptr) const
+	{
+		const size_t n = particles();
+		if (system.dimension() != dimension_ || (system.size() != 0 && system.size() != n)) {
+			throw std::invalid_argument("System does not match the checkpoint");
+		}
+		while (system.size() < n) {
+			system.add(1.0);
+		}
+		for (size_t i = 0; i < n; ++i) {
+			system.setMass(i, mass_[i]);
+		}
+		for (int c = 0; c < dimension_; ++c) {
+			std::copy(position_.begin() + c * n, position_.begin() + (c + 1) * n, system.position(c));
+			std::copy(velocity_.begin() + c * n, velocity_.begin() + (c + 1) * n, system.velocity(c));
+			std::copy(force_.begin() + c * n, force_.begin() + (c + 1) * n, system.force(c));
+		}
+		if (integrator != nullptr) {
+			integrator->restoreState(system, t, integrator_);
+		}
+	}
+
+	// Restore the random states, in the order they were captured
+	template <typename... Random>
+	void restoreRandom(Random&... random) const
+	{
+		std::istringstream in(random_);
+		int expand[] = { 0, (in >> random, 0)... };
+		(void)expand;
+		if (!in) {
+			throw std::invalid_argument("Random state does not match the checkpoint");
+		}
+	}
+
+	void write(std::ostream& out) const
+	{
+		const std::uint32_t fileVersion = version;
+		const std::uint32_t dimension = static_cast<std::uint32_t>(dimension_);
+		const std::uint64_t particles = mass_.size();
+		const std::uint64_t steps = step;
+		out.write(magic(), 8);
+		writeValue(out, fileVersion);
+		writeValue(out, dimension);
+		writeValue(out, particles);
+		writeValue(out, steps);
+		writeValue(out, t);
+		writeValue(out, dt);
+		writeDoubles(out, mass_);
+		writeDoubles(out, position_);
+		writeDoubles(out, velocity_);
+		writeDoubles(out, force_);
+		writeValue(out, static_cast<std::uint64_t>(integrator_.size()));
+		writeDoubles(out, integrator_);
+		writeValue(out, static_cast<std::uint64_t>(random_.size()));
+		out.write(random_.data(), static_cast<std::streamsize>(random_.size()));
+	}
+
+	void read(std::istream& in)
+	{
+		char tag[8];
+		std::uint32_t fileVersion = 0;
+		std::uint32_t dimension = 0;
+		std::uint64_t particles = 0;
+		std::uint64_t steps = 0;
+		in.read(tag, 8);
+		readValue(in, fileVersion);
+		if (!in || std::memcmp(tag, magic(), 8) != 0) {
+			throw std::invalid_argument("Not a checkpoint file");
+		}
+		if (fileVersion != version) {
+			throw std::invalid_argument("Unsupported checkpoint file version");
+		}
+		readValue(in, dimension);
+		readValue(in, particles);
+		readValue(in, steps);
+		readValue(in, t);
+		readValue(in, dt);
+		// Masses, positions, velocities and forces must fit in what is left
+		// of the file, so a corrupt header cannot ask for a huge allocation
+		const std::uint64_t doublesLeft = bytesLeft(in) / sizeof(double);
+		if (!in || dimension < 1 || particles > doublesLeft / (3 * std::uint64_t(dimension) + 1)) {
+			throw std::invalid_argument("Corrupt checkpoint file");
+		}
+		dimension_ = static_cast<int>(dimension);
+		step = static_cast<size_t>(steps);
+		readDoubles(in, mass_, particles);
+		readDoubles(in, position_, particles * dimension);
+		readDoubles(in, velocity_, particles * dimension);
+		readDoubles(in, force_, particles * dimension);
+		std::uint64_t count = 0;
+		readValue(in, count);
+		readDoubles(in, integrator_, count);
+		readValue(in, count);
+		if (in && count > bytesLeft(in)) {
+			throw std::invalid_argument("Corrupt checkpoint file");
+		}
+		random_.resize(in ? count : 0);
+		in.read(&random_[0], static_cast<std::streamsize>(random_.size()));
+		if (!in) {
+			throw std::invalid_argument("Truncated checkpoint file");
+		}
+	}
+
+private:
+	int dimension_ = 0;
+	vector<double> mass_;
+	vector<double> position_; // position_[c * n + i]
+	vector<double> velocity_;
+	vector<double> force_;
+	vector<double> integrator_;
+	string random_;
+};
+
+// Write `checkpoint` to `filename`, leaving the previous checkpoint intact
+// if the write fails
+inline void saveCheckpoint(const Checkpoint& checkpoint, const string& filename)
+{
+	replaceFile(filename, [&](std::ostream& out) { checkpoint.write(out); });
+}
+
+inline Checkpoint loadCheckpoint(const string& filename)
+{
+	std::ifstream in(filename, std::ios::binary);
+	if (!in) {
+		throw std::invalid_argument("Cannot open checkpoint file " + filename);
+	}
+	Checkpoint checkpoint;
+	checkpoint.read(in);
+	return checkpoint;
+}
+
+// Saves checkpoints every `interval` steps from a background thread.
+// save() copies the state into a spare checkpoint and hands it over; the
+// thread writes the newest one it has been given. If a save arrives while
+// the previous one is still waiting, the older is dropped rather than making
+// the simulation wait, since only the latest checkpoint is needed to restart.
+// The buffers are reused, so after the first saves no memory is allocated.
+class CheckpointWriter
+{
+public:
+	CheckpointWriter(const string& filename, size_t interval)
+		: filename_(filename), interval_(interval)
+	{
+		if (interval < 1) {
+			throw std::invalid_argument("Checkpoint interval must be positive");
+		}
+		thread_ = std::thread(&CheckpointWriter::run, this);
+	}
+
+	CheckpointWriter(const CheckpointWriter&) = delete;
+	CheckpointWriter& operator=(const CheckpointWriter&) = delete;
+
+	~CheckpointWriter()
+	{
+		try {
+			close();
+		}
+		catch (...) {
+			// Destructors must not throw; call close() to see write errors
+		}
+	}
+
+	size_t interval() const { return interval_; }
+	// Checkpoints handed over, and those replaced by a newer one before being written
+	size_t saved() const { return saved_; }
+	size_t dropped() const { return dropped_; }
+
+	// Save after `step` steps if it is a multiple of the interval; returns whether it did
+	template <typename... Random>
+	bool maybeSave(size_t step, double t, double dt, const ParticleSystem& system, const Integrator* integrator,
+		const Random&... random)
+	{
+		if (step % interval_ != 0) {
+			return false;
+		}
+		save(step, t, dt, system, integrator, random...);
+		return true;
+	}
+
+	template <typename... Random>
+	void save(size_t step, double t, double dt, const ParticleSystem& system, const Integrator* integrator,
+		const Random&... random)
+	{
+		if (!thread_.joinable()) {
+			throw std::logic_error("Checkpoint writer is closed");
+		}
+		spare_.capture(step, t, dt, system, integrator);
+		spare_.captureRandom(random...);
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			std::swap(spare_, pending_);
+			dropped_ += hasPending_ ? 1 : 0;
+			hasPending_ = true;
+		}
+		++saved_;
+		ready_.notify_one();
+	}
+
+	// Write the last checkpoint handed over and stop the thread; throws if a write failed
+	void close()
+	{
+		if (!thread_.joinable()) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			done_ = true;
+		}
+		ready_.notify_one();
+		thread_.join();
+		if (!error_.empty()) {
+			throw std::runtime_error(error_);
+		}
+	}
+
+private:
+	// Writer thread: write the newest pending checkpoint until closed
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		for (;;) {
+			ready_.wait(lock, [this] { return done_ || hasPending_; });
+			if (!hasPending_) {
+				break;
+			}
+			std::swap(pending_, writing_);
+			hasPending_ = false;
+			lock.unlock();
+			try {
+				saveCheckpoint(writing_, filename_);
+			}
+			catch (const std::exception& e) {
+				error_ = e.what();
+			}
+			lock.lock();
+		}
+	}
+
+	string filename_;
+	size_t interval_;
+	size_t saved_ = 0;
+	size_t dropped_ = 0;
+	Checkpoint spare_;   // filled by the compute thread
+	Checkpoint pending_; // handed over, not yet being written
+	Checkpoint writing_; // owned by the writer thread
+	bool hasPending_ = false;
+	bool done_ = false;
+	string error_;       // set by the writer thread, read after join
+	std::mutex mutex_;
+	std::condition_variable ready_;
+	std::thread thread_;
+};
+
+#endif
@@ -0,0 +1,167 @@
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <string>
+
+#include "ensemble.h"
+#include "trajectory.h"
+
+using namespace std;
+
+// Monte Carlo ensemble of the main.cpp particle: unit mass, at rest,
+// position uniform in [-1, 1] per component, pushed by sin(t + i) (plus
+// optional random velocity kicks). Prints the ensemble mean and variance of
+// the position every R time units and can save them for every step.
+// With --checkpoint the merged statistics are saved every N batches, and
+// --restart continues an interrupted run from that file.
+
+int main(int argc, char** argv)
+{
+	size_t realizations = 100000;
+	int dimension = 3;
+	double dt = 0.02;
+	double T = 4.0;
+	double report = 1.0;
+	double noise = 0.0;
+	unsigned long long seed = 5489;
+	unsigned numThreads = 0;
+	size_t batchSize = 4096;
+	string integrator = "euler";
+	string outputFile;
+	string checkpointFile;
+	size_t checkpointEvery = 16;
+	bool restart = false;
+	for (int i = 1; i < argc; ++i) {
+		string arg = argv[i];
+		if (arg == "--realizations" && i + 1 < argc) {
+			realizations = static_cast<size_t>(stod(argv[++i]));
+		}
+		else if (arg == "--dim" && i + 1 < argc) {
+			dimension = stoi(argv[++i]);
+		}
+		else if (arg == "--dt" && i + 1 < argc) {
+			dt = stod(argv[++i]);
+		}
+		else if (arg == "--time" && i + 1 < argc) {
+			T = stod(argv[++i]);
+		}
+		else if (arg == "--report" && i + 1 < argc) {
+			report = stod(argv[++i]);
+		}
+		else if (arg == "--noise" && i + 1 < argc) {
+			noise = stod(argv[++i]);
+		}
+		else if (arg == "--seed" && i + 1 < argc) {
+			seed = stoull(argv[++i]);
+		}
+		else if (arg == "--threads" && i + 1 < argc) {
+			numThreads = static_cast<unsigned>(stoul(argv[++i]));
+		}
+		else if (arg == "--batch" && i + 1 < argc) {
+			batchSize = static_cast<size_t>(stod(argv[++i]));
+		}
+		else if (arg == "--integrator" && i + 1 < argc) {
+			integrator = argv[++i];
+		}
+		else if (arg == "--output" && i + 1 < argc) {
+			outputFile = argv[++i];
+		}
+		else if (arg == "--checkpoint" && i + 1 < argc) {
+			checkpointFile = argv[++i];
+		}
+		else if (arg == "--checkpoint-every" && i + 1 < argc) {
+			checkpointEvery = static_cast<size_t>(stoul(argv[++i]));
+		}
+		else if (arg == "--restart") {
+			restart = true;
+		}
+		else {
+			cerr << "Usage: " << argv[0] << " [--realizations N] [--dim D] [--dt DT] [--time T] [--report R]"
+				<< " [--noise SIGMA] [--seed S] [--threads T] [--batch B] [--integrator NAME] [--output FILE]"
+				<< " [--checkpoint FILE] [--checkpoint-every N] [--restart]" << endl;
+			return 1;
+		}
+	}
+	if (restart && checkpointFile.empty()) {
+		cerr << "--restart needs --checkpoint FILE" << endl;
+		return 1;
+	}
+
+	Ensemble ensemble(dimension, realizations, seed);
+	ensemble.setIntegrator(integrator);
+	ensemble.setNoise(noise);
+	ensemble.setThreads(numThreads);
+	ensemble.setBatchSize(batchSize);
+	const size_t steps = static_cast<size_t>(std::llround(T / dt));
+
+	EnsembleProgress progress{ 0, EnsembleStatistics(dimension, steps, dt) };
+	try {
+		if (!checkpointFile.empty()) {
+			ensemble.setCheckpoint(checkpointFile, checkpointEvery);
+		}
+		if (restart && filesystem::exists(checkpointFile)) {
+			progress = ensemble.loadProgress(checkpointFile, dt, steps);
+			cout << "Restarting from batch " << progress.nextBatch << " of " << ensemble.batches() << endl;
+		}
+		else if (restart) {
+			cout << "No checkpoint " << checkpointFile << ", starting from the beginning" << endl;
+		}
+	}
+	catch (const exception& e) {
+		cerr << "Failed to restart: " << e.what() << endl;
+		return 1;
+	}
+	// Realizations left to run, for the timing
+	const size_t remaining = realizations - progress.statistics.realizations();
+
+	auto begin = chrono::steady_clock::now();
+	EnsembleStatistics statistics(dimension, steps, dt);
+	try {
+		statistics = ensemble.resume(dt, steps, progress);
+	}
+	catch (const exception& e) {
+		cerr << "Ensemble run failed: " << e.what() << endl;
+		return 1;
+	}
+	const double seconds = chrono::duration<double>(chrono::steady_clock::now() - begin).count();
+
+	cout << realizations << " realizations, " << dimension << "D, " << integrator << ", dt = " << dt
+		<< ", T = " << T << ", noise = " << noise << endl;
+	cout << fixed << setprecision(2);
+	if (remaining > 0 && steps > 0) {
+		cout << seconds << " s, "
+			<< seconds * 1e9 / (static_cast<double>(remaining) * steps) << " ns per particle-step" << endl;
+	}
+	cout << setw(8) << "time";
+	for (int c = 0; c < dimension; ++c) {
+		cout << setw(12) << ("mean " + trajectoryColumn(0, 1, c)) << setw(12) << ("var " + trajectoryColumn(0, 1, c));
+	}
+	cout << endl;
+	const size_t every = std::max<size_t>(1, static_cast<size_t>(std::llround(report / dt)));
+	for (size_t k = 0; k <= steps; k += every) {
+		cout << setw(8) << setprecision(2) << statistics.time(k) << setprecision(5);
+		for (int c = 0; c < dimension; ++c) {
+			cout << setw(12) << statistics.mean(k, c) << setw(12) << statistics.variance(k, c);
+		}
+		cout << endl;
+	}
+
+	if (!outputFile.empty()) {
+		ofstream out(outputFile);
+		out << "time";
+		for (int c = 0; c < dimension; ++c) {
+			out << " mean_" << trajectoryColumn(0, 1, c) << " var_" << trajectoryColumn(0, 1, c);
+		}
+		out << "\n" << setprecision(9);
+		for (size_t k = 0; k <= steps; ++k) {
+			out << statistics.time(k);
+			for (int c = 0; c < dimension; ++c) {
+				out << " " << statistics.mean(k, c) << " " << statistics.variance(k, c);
+			}
+			out << "\n";
+		}
+	}
+	return 0;
+}
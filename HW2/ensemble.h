@@ -0,0 +1,391 @@
+#ifndef ENSEMBLE_H
+#define ENSEMBLE_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <exception>
+#include <fstream>
+#include <functional>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "checkpoint.h"
+#include "integrators.h"
+#include "parallel.h"
+#include "particle_system.h"
+
+// Mean and variance of every position component over an ensemble, at each
+// output step k (time k * dt, k = 0 .. steps)
+class EnsembleStatistics
+{
+public:
+	EnsembleStatistics(int dimension, size_t steps, double dt)
+		: dimension_(dimension), steps_(steps), dt_(dt),
+		  mean_((steps + 1) * dimension, 0.0), m2_((steps + 1) * dimension, 0.0)
+	{
+	}
+
+	int dimension() const { return dimension_; }
+	size_t steps() const { return steps_; }
+	size_t realizations() const { return count_; }
+	double time(size_t k) const { return static_cast<double>(k) * dt_; }
+
+	double mean(size_t k, int c) const { return mean_[k * dimension_ + c]; }
+	// Sample variance (divided by realizations - 1)
+	double variance(size_t k, int c) const
+	{
+		return count_ > 1 ? m2_[k * dimension_ + c] / static_cast<double>(count_ - 1) : 0.0;
+	}
+
+	// Statistics of the particles of `system` at step k (the same particles at every step)
+	void observe(size_t k, const ParticleSystem& system)
+	{
+		const size_t n = system.size();
+		count_ = n;
+		for (int c = 0; c < dimension_; ++c) {
+			const double* x = system.position(c);
+			double sum = 0.0;
+			for (size_t i = 0; i < n; ++i) {
+				sum += x[i];
+			}
+			const double mean = sum / static_cast<double>(n);
+			double m2 = 0.0;
+			for (size_t i = 0; i < n; ++i) {
+				m2 += (x[i] - mean) * (x[i] - mean);
+			}
+			mean_[k * dimension_ + c] = mean;
+			m2_[k * dimension_ + c] = m2;
+		}
+	}
+
+	// Combine with the statistics of another, disjoint set of realizations
+	// (Chan et al.'s pairwise update of mean and sum of squared deviations)
+	void merge(const EnsembleStatistics& other)
+	{
+		if (other.dimension_ != dimension_ || other.steps_ != steps_) {
+			throw std::invalid_argument("Ensemble statistics do not match");
+		}
+		if (other.count_ == 0) {
+			return;
+		}
+		if (count_ == 0) {
+			*this = other;
+			return;
+		}
+		const double na = static_cast<double>(count_);
+		const double nb = static_cast<double>(other.count_);
+		const double n = na + nb;
+		for (size_t j = 0; j < mean_.size(); ++j) {
+			const double delta = other.mean_[j] - mean_[j];
+			mean_[j] += delta * nb / n;
+			m2_[j] += other.m2_[j] + delta * delta * na * nb / n;
+		}
+		count_ += other.count_;
+	}
+
+	// Binary state (realizations, means, squared deviations) for checkpoints;
+	// read() expects statistics of the same dimension and steps
+	void write(std::ostream& out) const
+	{
+		writeValue(out, static_cast<std::uint64_t>(count_));
+		writeDoubles(out, mean_);
+		writeDoubles(out, m2_);
+	}
+
+	void read(std::istream& in)
+	{
+		std::uint64_t count = 0;
+		readValue(in, count);
+		readDoubles(in, mean_, mean_.size());
+		readDoubles(in, m2_, m2_.size());
+		if (!in) {
+			throw std::invalid_argument("Truncated checkpoint file");
+		}
+		count_ = static_cast<size_t>(count);
+	}
+
+private:
+	int dimension_;
+	size_t steps_;
+	double dt_;
+	size_t count_ = 0;
+	vector<double> mean_; // mean_[k * dimension + c]
+	vector<double> m2_;   // sum of squared deviations from the mean
+};
+
+// Where a run stands: batches 0 .. nextBatch - 1 are merged into statistics
+struct EnsembleProgress
+{
+	size_t nextBatch;
+	EnsembleStatistics statistics;
+};
+
+// Monte Carlo ensemble of independent particles.
+// Realizations are cut into batches; each batch is a ParticleSystem that is
+// initialized from its own random stream, stepped to the end, and reduced to
+// per-step statistics as it goes, so no trajectory is ever stored and memory
+// stays at one batch per thread. Batch b draws from an mt19937_64 seeded with
+// (seed, b), and batches are merged in order, so the results are
+// reproducible bit for bit and do not depend on the number of threads.
+class Ensemble
+{
+public:
+	// Sets mass, position and velocity of particle i of a batch
+	using Initializer = std::function<void(std::mt19937_64& rng, ParticleSystem& batch, size_t i)>;
+
+	Ensemble(int dimension, size_t realizations, std::uint64_t seed = 5489)
+		: dimension_(dimension), realizations_(realizations), seed_(seed), initializer_(uniformStart),
+		  force_(sineForce)
+	{
+		if (dimension < 1) {
+			throw std::invalid_argument("Ensemble dimension must be positive");
+		}
+		if (realizations < 1) {
+			throw std::invalid_argument("Ensemble needs at least one realization");
+		}
+	}
+
+	// The start of main.cpp: unit mass, at rest, uniform in [-1, 1] per component
+	static void uniformStart(std::mt19937_64& rng, ParticleSystem& batch, size_t i)
+	{
+		std::uniform_real_distribution<double> dis(-1.0, 1.0);
+		batch.setMass(i, 1.0);
+		for (int c = 0; c < batch.dimension(); ++c) {
+			batch.position(c)[i] = dis(rng);
+			batch.velocity(c)[i] = 0.0;
+		}
+	}
+
+	void setInitializer(Initializer initializer) { initializer_ = std::move(initializer); }
+	// Force on every particle (independent particles: no pair forces)
+	void setForce(ForceKernel force) { force_ = std::move(force); }
+	// "euler", "verlet", "rk4" or "rk45", as for makeIntegrator
+	void setIntegrator(const string& type)
+	{
+		makeIntegrator(type);
+		integrator_ = type;
+	}
+	// Random velocity kicks: after each step every velocity component gets
+	// noise * sqrt(dt) * N(0, 1) (Euler-Maruyama for dv = F / m dt + noise dW)
+	void setNoise(double noise) { noise_ = noise; }
+	// Number of threads (0: all hardware threads)
+	void setThreads(unsigned threads) { threads_ = threads; }
+	// Realizations per batch; changing it changes the random streams
+	void setBatchSize(size_t batchSize)
+	{
+		if (batchSize < 1) {
+			throw std::invalid_argument("Ensemble batch size must be positive");
+		}
+		batchSize_ = batchSize;
+	}
+
+	// Save the progress to `filename` every `interval` merged batches and at
+	// the end of a run, so that an interrupted run can be resumed
+	void setCheckpoint(const string& filename, size_t interval)
+	{
+		if (interval < 1) {
+			throw std::invalid_argument("Checkpoint interval must be positive");
+		}
+		checkpoint_ = filename;
+		checkpointInterval_ = interval;
+	}
+
+	size_t batches() const { return (realizations_ + batchSize_ - 1) / batchSize_; }
+
+	// The random stream of batch b
+	std::mt19937_64 stream(size_t b) const
+	{
+		std::seed_seq seq{ static_cast<std::uint32_t>(seed_), static_cast<std::uint32_t>(seed_ >> 32),
+			static_cast<std::uint32_t>(b), static_cast<std::uint32_t>(static_cast<std::uint64_t>(b) >> 32) };
+		return std::mt19937_64(seq);
+	}
+
+	// Statistics of `steps` steps of size dt from t = 0
+	EnsembleStatistics run(double dt, size_t steps) const
+	{
+		return resume(dt, steps, EnsembleProgress{ 0, EnsembleStatistics(dimension_, steps, dt) });
+	}
+
+	// Finish a run from saved progress (see loadProgress): runs the remaining
+	// batches and gives the same statistics as an uninterrupted run
+	EnsembleStatistics resume(double dt, size_t steps, EnsembleProgress progress) const
+	{
+		checkProgress(progress, dt, steps);
+		EnsembleStatistics total = std::move(progress.statistics);
+		std::map<size_t, EnsembleStatistics> finished; // waiting for earlier batches
+		const size_t first = progress.nextBatch;
+		size_t nextBatch = first;
+		size_t lastSaved = first;
+		std::exception_ptr error; // the first failure of any thread
+		std::mutex mutex;
+		parallelFor(batches() - first, threads_, [&](size_t begin, size_t end) {
+			try {
+				for (size_t b = first + begin; b < first + end; ++b) {
+					EnsembleStatistics statistics = runBatch(b, dt, steps);
+					std::lock_guard<std::mutex> lock(mutex);
+					finished.emplace(b, std::move(statistics));
+					while (!finished.empty() && finished.begin()->first == nextBatch) {
+						total.merge(finished.begin()->second);
+						finished.erase(finished.begin());
+						++nextBatch;
+					}
+					if (!checkpoint_.empty() && nextBatch - lastSaved >= checkpointInterval_) {
+						saveProgress(checkpoint_, EnsembleProgress{ nextBatch, total });
+						lastSaved = nextBatch;
+					}
+				}
+			}
+			catch (...) {
+				std::lock_guard<std::mutex> lock(mutex);
+				if (!error) {
+					error = std::current_exception();
+				}
+			}
+		}, 1);
+		if (error) {
+			std::rethrow_exception(error);
+		}
+		if (!checkpoint_.empty() && lastSaved != nextBatch) {
+			saveProgress(checkpoint_, EnsembleProgress{ nextBatch, total });
+		}
+		return total;
+	}
+
+	// Ensemble progress file (native byte order):
+	//   magic "HW2ENSM\0" (8 bytes), uint32 version, uint32 dimension,
+	//   uint64 realizations, uint64 seed, uint64 batch size, uint64 steps,
+	//   double dt, double noise, uint64 length + bytes: integrator,
+	//   uint64 next batch, uint64 realizations merged,
+	//   doubles: means, then sums of squared deviations ([k * dimension + c])
+	// The initializer and force are not saved: set them up as in the original run.
+	void saveProgress(const string& filename, const EnsembleProgress& progress) const
+	{
+		replaceFile(filename, [&](std::ostream& out) {
+			const std::uint32_t version = 1;
+			out.write(progressMagic(), 8);
+			writeValue(out, version);
+			writeSettings(out, progress.statistics.steps(), progress.statistics.time(1));
+			writeValue(out, static_cast<std::uint64_t>(progress.nextBatch));
+			progress.statistics.write(out);
+		});
+	}
+
+	// Progress saved by a run with the same settings and batch size, the same
+	// dt and the same number of steps
+	EnsembleProgress loadProgress(const string& filename, double dt, size_t steps) const
+	{
+		std::ifstream in(filename, std::ios::binary);
+		if (!in) {
+			throw std::invalid_argument("Cannot open checkpoint file " + filename);
+		}
+		char tag[8];
+		std::uint32_t version = 0;
+		in.read(tag, 8);
+		readValue(in, version);
+		if (!in || std::memcmp(tag, progressMagic(), 8) != 0) {
+			throw std::invalid_argument("Not an ensemble checkpoint file");
+		}
+		if (version != 1) {
+			throw std::invalid_argument("Unsupported checkpoint file version");
+		}
+		std::ostringstream expected;
+		writeSettings(expected, steps, dt);
+		const string settings = expected.str();
+		string saved(settings.size(), '\0');
+		in.read(&saved[0], static_cast<std::streamsize>(saved.size()));
+		if (!in) {
+			throw std::invalid_argument("Truncated checkpoint file");
+		}
+		if (saved != settings) {
+			throw std::invalid_argument("Checkpoint does not match the ensemble");
+		}
+		std::uint64_t nextBatch = 0;
+		readValue(in, nextBatch);
+		EnsembleProgress progress{ static_cast<size_t>(nextBatch), EnsembleStatistics(dimension_, steps, dt) };
+		progress.statistics.read(in);
+		checkProgress(progress, dt, steps);
+		return progress;
+	}
+
+private:
+	static const char* progressMagic() { return "HW2ENSM"; }
+
+	// Everything that decides the statistics, as saved in progress files
+	void writeSettings(std::ostream& out, size_t steps, double dt) const
+	{
+		writeValue(out, static_cast<std::uint32_t>(dimension_));
+		writeValue(out, static_cast<std::uint64_t>(realizations_));
+		writeValue(out, seed_);
+		writeValue(out, static_cast<std::uint64_t>(batchSize_));
+		writeValue(out, static_cast<std::uint64_t>(steps));
+		writeValue(out, dt);
+		writeValue(out, noise_);
+		writeValue(out, static_cast<std::uint64_t>(integrator_.size()));
+		out.write(integrator_.data(), static_cast<std::streamsize>(integrator_.size()));
+	}
+
+	// The statistics must be those of batches 0 .. nextBatch - 1
+	void checkProgress(const EnsembleProgress& progress, double dt, size_t steps) const
+	{
+		const EnsembleStatistics& statistics = progress.statistics;
+		if (progress.nextBatch > batches() || statistics.dimension() != dimension_ || statistics.steps() != steps
+			|| statistics.time(1) != dt
+			|| statistics.realizations() != std::min(progress.nextBatch * batchSize_, realizations_)) {
+			throw std::invalid_argument("Progress does not match the ensemble");
+		}
+	}
+
+	EnsembleStatistics runBatch(size_t b, double dt, size_t steps) const
+	{
+		const size_t first = b * batchSize_;
+		const size_t count = std::min(batchSize_, realizations_ - first);
+		std::mt19937_64 rng = stream(b);
+		ParticleSystem batch(dimension_, count);
+		batch.setForce(force_);
+		for (size_t i = 0; i < count; ++i) {
+			batch.add(1.0);
+			initializer_(rng, batch, i);
+		}
+		unique_ptr<Integrator> integrator = makeIntegrator(integrator_);
+		std::normal_distribution<double> normal;
+		const double kick = noise_ * std::sqrt(dt);
+
+		EnsembleStatistics statistics(dimension_, steps, dt);
+		statistics.observe(0, batch);
+		for (size_t k = 0; k < steps; ++k) {
+			integrator->advance(batch, static_cast<double>(k) * dt, dt);
+			if (kick != 0.0) {
+				for (int c = 0; c < dimension_; ++c) {
+					double* v = batch.velocity(c);
+					for (size_t i = 0; i < count; ++i) {
+						v[i] += kick * normal(rng);
+					}
+				}
+			}
+			statistics.observe(k + 1, batch);
+		}
+		return statistics;
+	}
+
+	int dimension_;
+	size_t realizations_;
+	std::uint64_t seed_;
+	Initializer initializer_;
+	ForceKernel force_;
+	string integrator_ = "euler";
+	double noise_ = 0.0;
+	unsigned threads_ = 0;
+	size_t batchSize_ = 4096;
+	string checkpoint_; // no checkpoints if empty
+	size_t checkpointInterval_ = 1;
+};
+
+#endif
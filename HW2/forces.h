@@ -0,0 +1,74 @@
+#ifndef FORCES_H
+#define FORCES_H
+
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <functional>
+
+// Arrays handed to a force kernel for one evaluation over many particles.
+// Component c of particle i is position[c][i]; each array is contiguous.
+struct ForceBatch {
+	double t;
+	std::size_t count;              // number of particles
+	int dimension;                  // number of components
+	const double* mass;             // mass[i]
+	const double* const* position;  // position[c][i]
+	double* const* force;           // force[c][i]: the kernel adds its force here
+};
+
+// A force evaluated for a whole batch at once. Kernels add to `force`, so
+// several of them can act on the same particles.
+using ForceKernel = std::function<void(const ForceBatch&)>;
+
+// sin(i) and cos(i) for the first components, computed once
+struct ComponentAngles {
+	static const std::size_t size = 64;
+	std::array<double, size> sin;
+	std::array<double, size> cos;
+
+	ComponentAngles()
+	{
+		for (std::size_t i = 0; i < size; ++i) {
+			sin[i] = std::sin(static_cast<double>(i));
+			cos[i] = std::cos(static_cast<double>(i));
+		}
+	}
+
+	static const ComponentAngles& get()
+	{
+		static const ComponentAngles angles;
+		return angles;
+	}
+};
+
+/**
+ * Component i of the sin(t + i) force, given sinT = sin(t) and cosT = cos(t)
+ * Uses sin(t + i) = sin(t) cos(i) + cos(t) sin(i), so a whole force vector
+ * costs two transcendental calls instead of one per component (components
+ * past the table fall back to std::sin).
+ */
+inline double sineForceComponent(double t, double sinT, double cosT, std::size_t i)
+{
+	const ComponentAngles& angles = ComponentAngles::get();
+	if (i < ComponentAngles::size) {
+		return sinT * angles.cos[i] + cosT * angles.sin[i];
+	}
+	return std::sin(t + static_cast<double>(i));
+}
+
+// The homework force: component c of every particle is sin(t + c)
+inline void sineForce(const ForceBatch& batch)
+{
+	const double sinT = std::sin(batch.t);
+	const double cosT = std::cos(batch.t);
+	for (int c = 0; c < batch.dimension; ++c) {
+		const double value = sineForceComponent(batch.t, sinT, cosT, static_cast<std::size_t>(c));
+		double* __restrict f = batch.force[c];
+		for (std::size_t i = 0; i < batch.count; ++i) {
+			f[i] += value;
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,539 @@
+#ifndef INTEGRATORS_H
+#define INTEGRATORS_H
+
+#include <algorithm>
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+#include "particle_system.h"
+
+// Time integrator for x'' = F(t, x) / m.
+// advance() moves every particle of a ParticleSystem, or a single particle,
+// from t to t + dt; forces come from ParticleSystem::evaluateForces.
+// Integrators keep scratch arrays between calls, so after the first step they
+// do not allocate. Some reuse the last force evaluation of the previous step
+// when the next step starts where it ended; call reset() after changing
+// positions by hand.
+class Integrator
+{
+public:
+	virtual ~Integrator() {}
+
+	virtual string name() const = 0;
+	virtual void advance(ParticleSystem& system, double t, double dt) = 0;
+
+	// Same for a single particle, through a one-particle system. What was
+	// carried over from the last step only applies if this is the particle
+	// that step left behind, so stepping another particle (or one changed
+	// by hand) starts afresh.
+	template <typename V>
+	void advance(BasicParticle<V>& particle, double t, double dt)
+	{
+		const int dimension = particle.position_.size();
+		if (!single_ || single_->dimension() != dimension) {
+			single_.reset(new ParticleSystem(dimension, 1));
+			single_->add(particle);
+			reset();
+		}
+		else if (!holds(particle)) {
+			single_->store(0, particle);
+			reset();
+		}
+		advance(*single_, t, dt);
+		single_->load(0, particle);
+	}
+
+	virtual void reset() { cachedSystem_ = nullptr; }
+
+	// What the next step of `system` from t carries over from earlier steps,
+	// for checkpoints: here whether the system's force arrays already hold
+	// the forces at t
+	virtual vector<double> saveState(const ParticleSystem& system, double t) const
+	{
+		return { cached(system, t) ? 1.0 : 0.0 };
+	}
+
+	// Continue from a saved state; `system` must be in the state it was saved with
+	virtual void restoreState(const ParticleSystem& system, double t, const vector<double>& state)
+	{
+		reset();
+		if (!state.empty() && state[0] != 0.0) {
+			setCached(system, t);
+		}
+	}
+
+	// Number of force evaluations over the whole system so far
+	size_t forceEvaluations() const { return forceEvaluations_; }
+
+protected:
+	// Forces at `position` into `force`, counted
+	void evaluate(const ParticleSystem& system, double t, const double* const* position, double* const* force)
+	{
+		++forceEvaluations_;
+		system.evaluateForces(t, position, force);
+	}
+
+	// Whether the forces carried over from the last step are those of `system`
+	// at t (up to rounding: callers often step with t = k * dt)
+	bool cached(const ParticleSystem& system, double t) const
+	{
+		return cachedSystem_ == &system && cachedSize_ == system.size()
+			&& std::fabs(cachedTime_ - t) <= 1e-12 * std::max(1.0, std::fabs(t));
+	}
+
+	void setCached(const ParticleSystem& system, double t)
+	{
+		cachedSystem_ = &system;
+		cachedTime_ = t;
+		cachedSize_ = system.size();
+	}
+
+	size_t forceEvaluations_ = 0;
+
+private:
+	// Whether the one-particle system holds exactly `particle`
+	template <typename V>
+	bool holds(const BasicParticle<V>& particle) const
+	{
+		if (single_->mass(0) != particle.mass_) {
+			return false;
+		}
+		for (int c = 0; c < single_->dimension(); ++c) {
+			if (single_->position(c)[0] != particle.position_.components_[c]
+				|| single_->velocity(c)[0] != particle.velocity_.components_[c]
+				|| single_->force(c)[0] != particle.force_.components_[c]) {
+				return false;
+			}
+		}
+		return true;
+	}
+
+	unique_ptr<ParticleSystem> single_;
+	const ParticleSystem* cachedSystem_ = nullptr;
+	double cachedTime_ = 0.0;
+	size_t cachedSize_ = 0;
+};
+
+// First order: the Euler step of Particle::update (one force evaluation per step)
+class EulerIntegrator : public Integrator
+{
+public:
+	using Integrator::advance;
+
+	string name() const override { return "euler"; }
+
+	void advance(ParticleSystem& system, double t, double dt) override
+	{
+		++forceEvaluations_;
+		system.update(t, dt);
+	}
+};
+
+// Second order, symplectic: kick-drift-kick velocity Verlet. The force at
+// the end of a step is kept in the system's force arrays and starts the
+// next one, so a step costs one force evaluation.
+class VelocityVerletIntegrator : public Integrator
+{
+public:
+	using Integrator::advance;
+
+	string name() const override { return "verlet"; }
+
+	void advance(ParticleSystem& system, double t, double dt) override
+	{
+		const int dimension = system.dimension();
+		const size_t n = system.size();
+		positions_.resize(dimension);
+		forces_.resize(dimension);
+		for (int c = 0; c < dimension; ++c) {
+			positions_[c] = system.position(c);
+			forces_[c] = system.force(c);
+		}
+		if (!cached(system, t)) {
+			evaluate(system, t, positions_.data(), forces_.data());
+		}
+
+		const double* __restrict inverseMass = system.inverseMasses();
+		const double halfStep = 0.5 * dt;
+		for (int c = 0; c < dimension; ++c) {
+			const double* __restrict f = system.force(c);
+			double* __restrict v = system.velocity(c);
+			double* __restrict x = system.position(c);
+			for (size_t i = 0; i < n; ++i) {
+				v[i] += halfStep * (f[i] * inverseMass[i]);
+				x[i] += dt * v[i];
+			}
+		}
+		evaluate(system, t + dt, positions_.data(), forces_.data());
+		for (int c = 0; c < dimension; ++c) {
+			const double* __restrict f = system.force(c);
+			double* __restrict v = system.velocity(c);
+			for (size_t i = 0; i < n; ++i) {
+				v[i] += halfStep * (f[i] * inverseMass[i]);
+			}
+		}
+		setCached(system, t + dt);
+	}
+
+private:
+	vector<const double*> positions_;
+	vector<double*> forces_;
+};
+
+// Explicit Runge-Kutta method given by its Butcher tableau, applied to the
+// first-order system (x, v)' = (v, F(t, x) / m).
+// Since the x-stages of that system are v-stages integrated once more, only
+// the accelerations k_s are stored: the stage positions are
+//   x_s = x + c_s h v + h^2 sum_l (A A)_sl k_l
+// and the step is
+//   x' = x + h v + h^2 sum_l (b A)_l k_l,   v' = v + h sum_l b_l k_l.
+// The system's force arrays are left as they were.
+class RungeKuttaIntegrator : public Integrator
+{
+public:
+	using Integrator::advance;
+
+protected:
+	// `a` is the strictly lower triangular stage matrix, `b` the weights and
+	// `bError` the difference between `b` and the weights of an embedded
+	// lower-order method (empty if there is none)
+	RungeKuttaIntegrator(const vector<vector<double>>& a, const vector<double>& b,
+		const vector<double>& bError = vector<double>())
+		: stages_(static_cast<int>(b.size())), a_(a), b_(b), e_(bError), c_(b.size(), 0.0),
+		  aa_(b.size(), vector<double>(b.size(), 0.0)), ba_(b.size(), 0.0), ea_(b.size(), 0.0),
+		  k_(b.size())
+	{
+		for (int s = 0; s < stages_; ++s) {
+			for (int j = 0; j < s; ++j) {
+				c_[s] += a_[s][j];
+				for (int l = 0; l < j; ++l) {
+					aa_[s][l] += a_[s][j] * a_[j][l];
+				}
+			}
+			for (int l = 0; l < s; ++l) {
+				ba_[l] += b_[s] * a_[s][l];
+				if (!e_.empty()) {
+					ea_[l] += e_[s] * a_[s][l];
+				}
+			}
+		}
+	}
+
+	// Make stage 0 read the system's own position arrays
+	void pointAtSystem(const ParticleSystem& system)
+	{
+		systemPositions_.resize(system.dimension());
+		for (int c = 0; c < system.dimension(); ++c) {
+			systemPositions_[c] = system.position(c);
+		}
+	}
+
+	// Compute the stages of a step of size h from the system state at t.
+	// Stage 0 is skipped when `firstStageReady` (k_0 is already in place).
+	void computeStages(const ParticleSystem& system, double t, double h, bool firstStageReady)
+	{
+		const int dimension = system.dimension();
+		const size_t n = system.size();
+		prepare(dimension, n);
+		for (int s = firstStageReady ? 1 : 0; s < stages_; ++s) {
+			const double* const* stagePosition = systemPositions_.data();
+			if (s > 0) {
+				for (int c = 0; c < dimension; ++c) {
+					const double* __restrict x = system.position(c);
+					const double* __restrict v = system.velocity(c);
+					double* __restrict xs = trial_.data() + c * n;
+					const double ch = c_[s] * h;
+					for (size_t i = 0; i < n; ++i) {
+						xs[i] = x[i] + ch * v[i];
+					}
+					for (int l = 0; l < s; ++l) {
+						if (aa_[s][l] != 0.0) {
+							accumulate(xs, k_[l].data() + c * n, aa_[s][l] * h * h, n);
+						}
+					}
+				}
+				stagePosition = trialPositions_.data();
+			}
+			evaluate(system, t + c_[s] * h, stagePosition, stageForces_[s].data());
+			const double* __restrict inverseMass = system.inverseMasses();
+			for (int c = 0; c < dimension; ++c) {
+				double* __restrict k = k_[s].data() + c * n;
+				for (size_t i = 0; i < n; ++i) {
+					k[i] *= inverseMass[i];
+				}
+			}
+		}
+	}
+
+	// Position and velocity increments of the step, into dx_ and dv_
+	// (component c at offset c * n)
+	void computeIncrements(const ParticleSystem& system, double h)
+	{
+		const size_t n = system.size();
+		for (int c = 0; c < system.dimension(); ++c) {
+			const double* __restrict v = system.velocity(c);
+			double* __restrict dx = dx_.data() + c * n;
+			double* __restrict dv = dv_.data() + c * n;
+			for (size_t i = 0; i < n; ++i) {
+				dx[i] = h * v[i];
+				dv[i] = 0.0;
+			}
+			for (int l = 0; l < stages_; ++l) {
+				if (ba_[l] != 0.0) {
+					accumulate(dx, k_[l].data() + c * n, ba_[l] * h * h, n);
+				}
+				if (b_[l] != 0.0) {
+					accumulate(dv, k_[l].data() + c * n, b_[l] * h, n);
+				}
+			}
+		}
+	}
+
+	// Add the increments to the system state
+	void applyIncrements(ParticleSystem& system)
+	{
+		const size_t n = system.size();
+		for (int c = 0; c < system.dimension(); ++c) {
+			accumulate(system.position(c), dx_.data() + c * n, 1.0, n);
+			accumulate(system.velocity(c), dv_.data() + c * n, 1.0, n);
+		}
+	}
+
+	// Largest error estimate of the embedded method, in units of
+	// atol + rtol * |value|, over every position and velocity component
+	double errorNorm(const ParticleSystem& system, double h, double rtol, double atol) const
+	{
+		const size_t n = system.size();
+		double worst = 0.0;
+		for (int c = 0; c < system.dimension(); ++c) {
+			const double* x = system.position(c);
+			const double* v = system.velocity(c);
+			const double* dx = dx_.data() + c * n;
+			const double* dv = dv_.data() + c * n;
+			for (size_t i = 0; i < n; ++i) {
+				double ex = 0.0;
+				double ev = 0.0;
+				for (int l = 0; l < stages_; ++l) {
+					const double k = k_[l][c * n + i];
+					ex += ea_[l] * k;
+					ev += e_[l] * k;
+				}
+				ex *= h * h;
+				ev *= h;
+				const double sx = atol + rtol * std::max(std::fabs(x[i]), std::fabs(x[i] + dx[i]));
+				const double sv = atol + rtol * std::max(std::fabs(v[i]), std::fabs(v[i] + dv[i]));
+				worst = std::max(worst, std::max(std::fabs(ex) / sx, std::fabs(ev) / sv));
+			}
+		}
+		return worst;
+	}
+
+	static void accumulate(double* __restrict y, const double* __restrict x, double scale, size_t n)
+	{
+		for (size_t i = 0; i < n; ++i) {
+			y[i] += scale * x[i];
+		}
+	}
+
+	// Size the scratch arrays and point the pointer tables at them
+	void prepare(int dimension, size_t n)
+	{
+		const size_t total = static_cast<size_t>(dimension) * n;
+		trial_.resize(total);
+		dx_.resize(total);
+		dv_.resize(total);
+		trialPositions_.resize(dimension);
+		systemPositions_.resize(dimension);
+		stageForces_.resize(stages_);
+		for (int s = 0; s < stages_; ++s) {
+			k_[s].resize(total);
+			stageForces_[s].resize(dimension);
+		}
+		for (int c = 0; c < dimension; ++c) {
+			trialPositions_[c] = trial_.data() + c * n;
+			for (int s = 0; s < stages_; ++s) {
+				stageForces_[s][c] = k_[s].data() + c * n;
+			}
+		}
+	}
+
+	int stages_;
+	vector<vector<double>> a_;
+	vector<double> b_;
+	vector<double> e_;
+	vector<double> c_;
+	vector<vector<double>> aa_; // A A
+	vector<double> ba_;         // b A
+	vector<double> ea_;         // bError A
+	vector<vector<double>> k_;  // accelerations of each stage
+	vector<double> trial_;      // stage positions
+	vector<double> dx_;
+	vector<double> dv_;
+	vector<const double*> systemPositions_;
+	vector<const double*> trialPositions_;
+	vector<vector<double*>> stageForces_;
+};
+
+// Classical fourth-order Runge-Kutta (four force evaluations per step)
+class RK4Integrator : public RungeKuttaIntegrator
+{
+public:
+	using Integrator::advance;
+
+	RK4Integrator()
+		: RungeKuttaIntegrator({ {}, { 0.5 }, { 0.0, 0.5 }, { 0.0, 0.0, 1.0 } },
+			{ 1.0 / 6.0, 1.0 / 3.0, 1.0 / 3.0, 1.0 / 6.0 })
+	{
+	}
+
+	string name() const override { return "rk4"; }
+
+	void advance(ParticleSystem& system, double t, double dt) override
+	{
+		pointAtSystem(system);
+		computeStages(system, t, dt, false);
+		computeIncrements(system, dt);
+		applyIncrements(system);
+	}
+};
+
+// Adaptive Dormand-Prince 5(4): fifth-order steps whose size is chosen from
+// the embedded fourth-order error estimate, so that every position and
+// velocity component stays within atol + rtol * |value| per step.
+// advance() takes as many internal steps as needed to reach t + dt exactly;
+// the step size carries over between calls. The last stage is evaluated at
+// the end of the step and reused as the first stage of the next one.
+class DormandPrinceIntegrator : public RungeKuttaIntegrator
+{
+public:
+	using Integrator::advance;
+
+	explicit DormandPrinceIntegrator(double rtol = 1e-6, double atol = 1e-9)
+		: RungeKuttaIntegrator(
+			{ {},
+			  { 1.0 / 5.0 },
+			  { 3.0 / 40.0, 9.0 / 40.0 },
+			  { 44.0 / 45.0, -56.0 / 15.0, 32.0 / 9.0 },
+			  { 19372.0 / 6561.0, -25360.0 / 2187.0, 64448.0 / 6561.0, -212.0 / 729.0 },
+			  { 9017.0 / 3168.0, -355.0 / 33.0, 46732.0 / 5247.0, 49.0 / 176.0, -5103.0 / 18656.0 },
+			  { 35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0 } },
+			{ 35.0 / 384.0, 0.0, 500.0 / 1113.0, 125.0 / 192.0, -2187.0 / 6784.0, 11.0 / 84.0, 0.0 },
+			{ 35.0 / 384.0 - 5179.0 / 57600.0, 0.0, 500.0 / 1113.0 - 7571.0 / 16695.0,
+			  125.0 / 192.0 - 393.0 / 640.0, -2187.0 / 6784.0 + 92097.0 / 339200.0,
+			  11.0 / 84.0 - 187.0 / 2100.0, -1.0 / 40.0 }),
+		  rtol_(rtol), atol_(atol)
+	{
+		if (!(rtol > 0.0) || !(atol > 0.0)) {
+			throw std::invalid_argument("Integrator tolerances must be positive");
+		}
+	}
+
+	string name() const override { return "rk45"; }
+
+	void advance(ParticleSystem& system, double t, double dt) override
+	{
+		pointAtSystem(system);
+		const double end = t + dt;
+		double time = t;
+		double h = step_ > 0.0 ? std::min(step_, dt) : dt;
+		while (time < end) {
+			const double proposed = h;
+			const bool last = time + 1.000001 * h >= end;
+			if (last) {
+				h = end - time;
+			}
+			computeStages(system, time, h, cached(system, time));
+			computeIncrements(system, h);
+			const double error = errorNorm(system, h, rtol_, atol_);
+			double factor = error > 0.0 ? 0.9 * std::pow(error, -0.2) : 5.0;
+			factor = std::min(5.0, std::max(0.2, factor));
+			if (error <= 1.0) {
+				applyIncrements(system);
+				time = last ? end : time + h;
+				// The last stage was evaluated at the new state
+				std::swap(k_[0], k_[stages_ - 1]);
+				setCached(system, time);
+				++accepted_;
+				// A step shortened to land on `end` says little about the next one
+				h = last ? std::max(proposed, h * factor) : h * factor;
+			}
+			else {
+				// Retry from the same state: the first stage is still valid
+				setCached(system, time);
+				++rejected_;
+				h *= factor;
+			}
+			if (h < 1e-14 * std::max(1.0, std::fabs(time))) {
+				throw std::runtime_error("Integrator step size underflow");
+			}
+		}
+		step_ = h;
+	}
+
+	void reset() override
+	{
+		Integrator::reset();
+		step_ = 0.0;
+	}
+
+	// Also the step size and the first stage (the last one of the previous step)
+	vector<double> saveState(const ParticleSystem& system, double t) const override
+	{
+		vector<double> state = Integrator::saveState(system, t);
+		state.push_back(step_);
+		if (state[0] != 0.0) {
+			state.insert(state.end(), k_[0].begin(), k_[0].end());
+		}
+		return state;
+	}
+
+	void restoreState(const ParticleSystem& system, double t, const vector<double>& state) override
+	{
+		Integrator::restoreState(system, t, state);
+		if (state.size() < 2) {
+			throw std::invalid_argument("Integrator state does not match the integrator");
+		}
+		step_ = state[1];
+		if (state[0] != 0.0) {
+			prepare(system.dimension(), system.size());
+			if (state.size() != 2 + k_[0].size()) {
+				throw std::invalid_argument("Integrator state does not match the system");
+			}
+			std::copy(state.begin() + 2, state.end(), k_[0].begin());
+		}
+	}
+
+	size_t acceptedSteps() const { return accepted_; }
+	size_t rejectedSteps() const { return rejected_; }
+
+private:
+	double rtol_;
+	double atol_;
+	double step_ = 0.0; // next step size (0 until the first step)
+	size_t accepted_ = 0;
+	size_t rejected_ = 0;
+};
+
+// Integrator by name: "euler", "verlet", "rk4" or "rk45" (with the
+// given tolerances)
+inline unique_ptr<Integrator> makeIntegrator(const string& type, double rtol = 1e-6, double atol = 1e-9)
+{
+	if (type == "euler") {
+		return unique_ptr<Integrator>(new EulerIntegrator());
+	}
+	else if (type == "verlet") {
+		return unique_ptr<Integrator>(new VelocityVerletIntegrator());
+	}
+	else if (type == "rk4") {
+		return unique_ptr<Integrator>(new RK4Integrator());
+	}
+	else if (type == "rk45") {
+		return unique_ptr<Integrator>(new DormandPrinceIntegrator(rtol, atol));
+	}
+	throw std::invalid_argument("Unknown integrator type");
+}
+
+#endif
@@ -6,9 +6,17 @@
 #include <random>
 
 #include "homework2_skeleton.cpp"
+#include "trajectory.h"
 
 using namespace std;
 
+// Binary trajectory next to a text file: traject_2d.txt -> traject_2d.traj
+string binaryName(const string& textFile)
+{
+    const size_t dot = textFile.rfind('.');
+    return (dot == string::npos ? textFile : textFile.substr(0, dot)) + ".traj";
+}
+
 int main(int argc, char** argv)
 {
     string file2d = "traject_2d.txt";
@@ -20,14 +28,10 @@ int main(int argc, char** argv)
         file3d = argv[2];
         file6d = argv[3];
     }
-
-    ofstream out2d(file2d);
-    ofstream out3d(file3d);
-    ofstream out6d(file6d);
-    
-    if (!out2d || !out3d || !out6d) {
-        cerr << "Failed to open output files" << endl;
-        return 1;
+    // Keep every stride-th step (default: all of them)
+    size_t stride = 1;
+    if (argc >= 5) {
+        stride = static_cast<size_t>(stoul(argv[4]));
     }
 
     // Random number generator for initial positions
@@ -40,57 +44,70 @@ int main(int argc, char** argv)
     double T = 4.0;    
 
     // Initialize particles with random positions and zero velocity
+    // Fixed-size vectors: the particle updates do no heap allocation
     // 2D particle
-    Vector pos2d(dis(gen), dis(gen));
-    Vector vel2d(0.0, 0.0);  
-    Vector force2d(0.0, 0.0);
-    Particle p2d(1.0, pos2d, vel2d, force2d);
+    Vector2 pos2d(dis(gen), dis(gen));
+    Vector2 vel2d(0.0, 0.0);  
+    Vector2 force2d(0.0, 0.0);
+    ParticleN<2> p2d(1.0, pos2d, vel2d, force2d);
 
     // 3D particle
-    Vector pos3d(dis(gen), dis(gen), dis(gen));
-    Vector vel3d(0.0, 0.0, 0.0);  
-    Vector force3d(0.0, 0.0, 0.0);
-    Particle p3d(1.0, pos3d, vel3d, force3d);
+    Vector3 pos3d(dis(gen), dis(gen), dis(gen));
+    Vector3 vel3d(0.0, 0.0, 0.0);  
+    Vector3 force3d(0.0, 0.0, 0.0);
+    ParticleN<3> p3d(1.0, pos3d, vel3d, force3d);
 
     // 6D particle
-    Vector pos6d(dis(gen), dis(gen), dis(gen), dis(gen), dis(gen), dis(gen));
-    Vector vel6d(0.0, 0.0, 0.0, 0.0, 0.0, 0.0); 
-    Vector force6d(0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
-    Particle p6d(1.0, pos6d, vel6d, force6d);
-
-    // Headers
-    out2d << "time x y" << endl;
-    out3d << "time x y z" << endl;
-    out6d << "time x y z w u v" << endl;
-
-    cout << "Starting simulation with PDF-compliant parameters:" << endl;
-    cout << "dt = " << dt << ", T = " << T << endl;
-    cout << "2D initial position: " << pos2d << endl;
-    cout << "3D initial position: " << pos3d << endl;
-    cout << "6D initial position: " << pos6d << endl;
-
-    // Euler integration loop
-    for (t = 0.0; t <= T + 1e-12; t += dt) {
-        // Log current state
-        out2d << t << " " << p2d.position_[0] << " " << p2d.position_[1] << endl;
-        out3d << t << " " << p3d.position_[0] << " " << p3d.position_[1] << " " << p3d.position_[2] << endl;
-        out6d << t << " " << p6d.position_[0] << " " << p6d.position_[1] << " " << p6d.position_[2] 
-              << " " << p6d.position_[3] << " " << p6d.position_[4] << " " << p6d.position_[5] << endl;
-
-        // Advance particles using Euler method
-        p2d.update(t, dt);
-        p3d.update(t, dt);
-        p6d.update(t, dt);
+    Vector6 pos6d(dis(gen), dis(gen), dis(gen), dis(gen), dis(gen), dis(gen));
+    Vector6 vel6d(0.0, 0.0, 0.0, 0.0, 0.0, 0.0); 
+    Vector6 force6d(0.0, 0.0, 0.0, 0.0, 0.0, 0.0);
+    ParticleN<6> p6d(1.0, pos6d, vel6d, force6d);
+
+    // The writers and the conversion throw if a file cannot be opened or written
+    try {
+        // The states are written in binary by background threads while the
+        // particles move, and turned into the text files afterwards
+        TrajectoryWriter out2d(binaryName(file2d), 2, 1, stride);
+        TrajectoryWriter out3d(binaryName(file3d), 3, 1, stride);
+        TrajectoryWriter out6d(binaryName(file6d), 6, 1, stride);
+
+        cout << "Starting simulation with PDF-compliant parameters:" << endl;
+        cout << "dt = " << dt << ", T = " << T << endl;
+        cout << "2D initial position: " << pos2d << endl;
+        cout << "3D initial position: " << pos3d << endl;
+        cout << "6D initial position: " << pos6d << endl;
+
+        // Euler integration loop
+        for (t = 0.0; t <= T + 1e-12; t += dt) {
+            // Log current state
+            out2d.record(t, p2d);
+            out3d.record(t, p3d);
+            out6d.record(t, p6d);
+
+            // Advance particles using Euler method
+            p2d.update(t, dt);
+            p3d.update(t, dt);
+            p6d.update(t, dt);
+        }
+
+        out2d.close();
+        out3d.close();
+        out6d.close();
+        convertTrajectoryToText(binaryName(file2d), file2d);
+        convertTrajectoryToText(binaryName(file3d), file3d);
+        convertTrajectoryToText(binaryName(file6d), file6d);
+    }
+    catch (const exception& e) {
+        cerr << "Failed to write output files: " << e.what() << endl;
+        return 1;
     }
-
-    out2d.close();
-    out3d.close();
-    out6d.close();
 
     cout << "Simulation completed. Data saved to:" << endl;
     cout << "- " << file2d << " (2D trajectory)" << endl;
     cout << "- " << file3d << " (3D trajectory)" << endl;
     cout << "- " << file6d << " (6D trajectory)" << endl;
+    cout << "(binary copies: " << binaryName(file2d) << ", " << binaryName(file3d) << ", "
+         << binaryName(file6d) << ")" << endl;
 
     return 0;
 }
@@ -0,0 +1,541 @@
+#ifndef NBODY_H
+#define NBODY_H
+
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <thread>
+#include <vector>
+
+#include "forces.h"
+#include "parallel.h"
+
+// How pairwise forces are evaluated
+enum class PairMethod {
+	BruteForce, // every pair: exact, O(N^2)
+	CellList,   // only pairs in neighbouring cells no smaller than the cutoff: O(N) for short-range forces
+	BarnesHut   // distant groups replaced by their centre of mass: O(N log N), approximate, for gravity
+};
+
+// Newtonian gravity with Plummer softening. The force on i from j is
+// scale * (x_j - x_i) with scale = G m_i m_j / (r^2 + softening^2)^(3/2).
+struct GravityPotential {
+	double G;
+	double softening2;
+
+	double scale(double r2, double mi, double mj) const
+	{
+		const double s = r2 + softening2;
+		return G * mi * mj / (s * std::sqrt(s));
+	}
+};
+
+// Lennard-Jones 12-6 potential 4 epsilon ((sigma/r)^12 - (sigma/r)^6). The
+// force on i from j is scale * (x_j - x_i) with
+// scale = -24 epsilon (2 (sigma/r)^12 - (sigma/r)^6) / r^2.
+struct LennardJonesPotential {
+	double epsilon;
+	double sigma2;
+
+	double scale(double r2, double, double) const
+	{
+		const double s2 = sigma2 / r2;
+		const double s6 = s2 * s2 * s2;
+		return -24.0 * epsilon * s6 * (2.0 * s6 - 1.0) / r2;
+	}
+};
+
+// Pairwise interaction force between all particles of a system, as a force
+// kernel: system.addForce(PairForce::gravity(...)).
+// Works in 1, 2 and 3 dimensions. Every particle's force is summed by one
+// thread in a fixed order, so results do not depend on the thread count.
+class PairForce
+{
+public:
+	/**
+	 * Gravity between every pair of particles
+	 * @param G: gravitational constant
+	 * @param softening: Plummer softening length (avoids the singularity at r = 0)
+	 * @param method: BruteForce or BarnesHut (gravity has no cutoff for cell lists)
+	 * @param theta: Barnes-Hut opening angle; a cell of size s at distance d
+	 *               is used as a whole when s < theta d (0 gives the exact sum)
+	 * @param numThreads: worker threads (0 means one per core)
+	 */
+	static PairForce gravity(double G, double softening, PairMethod method, double theta = 0.5,
+		unsigned numThreads = 0)
+	{
+		if (method == PairMethod::CellList) {
+			throw std::invalid_argument("Cell lists need a cutoff; use BruteForce or BarnesHut for gravity");
+		}
+		PairForce force(Kind::Gravity, method, numThreads);
+		force.gravity_ = GravityPotential{ G, softening * softening };
+		force.theta2_ = theta * theta;
+		return force;
+	}
+
+	/**
+	 * Lennard-Jones forces between pairs closer than `cutoff`
+	 * @param epsilon: depth of the potential well
+	 * @param sigma: distance at which the potential is zero
+	 * @param cutoff: pairs further apart do not interact (typically 2.5 sigma)
+	 * @param method: BruteForce or CellList (short-range forces gain nothing from Barnes-Hut)
+	 * @param numThreads: worker threads (0 means one per core)
+	 */
+	static PairForce lennardJones(double epsilon, double sigma, double cutoff, PairMethod method,
+		unsigned numThreads = 0)
+	{
+		if (method == PairMethod::BarnesHut) {
+			throw std::invalid_argument("Barnes-Hut is for long-range forces; use BruteForce or CellList");
+		}
+		if (!(cutoff > 0.0)) {
+			throw std::invalid_argument("Lennard-Jones cutoff must be positive");
+		}
+		PairForce force(Kind::LennardJones, method, numThreads);
+		force.lennardJones_ = LennardJonesPotential{ epsilon, sigma * sigma };
+		force.cutoff_ = cutoff;
+		return force;
+	}
+
+	PairMethod method() const { return method_; }
+
+	// Add the pair forces on every particle of the batch
+	void operator()(const ForceBatch& batch)
+	{
+		switch (batch.dimension) {
+		case 1: dispatch<1>(batch); break;
+		case 2: dispatch<2>(batch); break;
+		case 3: dispatch<3>(batch); break;
+		default: throw std::invalid_argument("Pair forces support 1 to 3 dimensions");
+		}
+	}
+
+private:
+	enum class Kind { Gravity, LennardJones };
+
+	// Barnes-Hut tree node: a cube holding the particles order_[first, first + count)
+	struct TreeNode {
+		std::array<double, 3> low;    // lower corner
+		std::array<double, 3> center; // centre of mass
+		double size;                  // edge length
+		double mass;
+		std::uint32_t first;
+		std::uint32_t count;
+		std::int32_t child;           // first of the 2^D children, or -1 for a leaf
+	};
+
+	static const std::uint32_t leafSize = 8;
+	static const int maxDepth = 40;
+
+	PairForce(Kind kind, PairMethod method, unsigned numThreads)
+		: kind_(kind), method_(method), numThreads_(numThreads), gravity_{ 0.0, 0.0 },
+		  lennardJones_{ 0.0, 0.0 }, cutoff_(0.0), theta2_(0.0)
+	{
+	}
+
+	template <int D>
+	void dispatch(const ForceBatch& batch)
+	{
+		if (kind_ == Kind::Gravity) {
+			evaluate<D>(batch, gravity_, -1.0);
+		}
+		else {
+			evaluate<D>(batch, lennardJones_, cutoff_ * cutoff_);
+		}
+	}
+
+	// cutoff2 < 0 means no cutoff
+	template <int D, typename Potential>
+	void evaluate(const ForceBatch& batch, const Potential& potential, double cutoff2)
+	{
+		if (batch.count == 0) {
+			return;
+		}
+		switch (method_) {
+		case PairMethod::BruteForce: bruteForce<D>(batch, potential, cutoff2); break;
+		case PairMethod::CellList: cellList<D>(batch, potential, cutoff2); break;
+		case PairMethod::BarnesHut: barnesHut<D>(batch, potential); break;
+		}
+	}
+
+	template <int D, typename Potential>
+	void bruteForce(const ForceBatch& batch, const Potential& potential, double cutoff2)
+	{
+		const std::size_t n = batch.count;
+		const double limit = cutoff2 >= 0.0 ? cutoff2 : HUGE_VAL;
+		std::array<const double*, D> x;
+		for (int c = 0; c < D; ++c) {
+			x[c] = batch.position[c];
+		}
+		const double* mass = batch.mass;
+		parallelFor(n, numThreads_, [&](std::size_t begin, std::size_t end) {
+			for (std::size_t i = begin; i < end; ++i) {
+				std::array<double, D> xi;
+				std::array<double, D> acc{};
+				for (int c = 0; c < D; ++c) {
+					xi[c] = x[c][i];
+				}
+				const double mi = mass[i];
+				for (std::size_t j = 0; j < n; ++j) {
+					std::array<double, D> d;
+					double r2 = 0.0;
+					for (int c = 0; c < D; ++c) {
+						d[c] = x[c][j] - xi[c];
+						r2 += d[c] * d[c];
+					}
+					if (j == i || r2 >= limit) {
+						continue;
+					}
+					const double s = potential.scale(r2, mi, mass[j]);
+					for (int c = 0; c < D; ++c) {
+						acc[c] += s * d[c];
+					}
+				}
+				for (int c = 0; c < D; ++c) {
+					batch.force[c][i] += acc[c];
+				}
+			}
+		});
+	}
+
+	// Bounding box of the particles
+	template <int D>
+	static void bounds(const ForceBatch& batch, std::array<double, D>& low, std::array<double, D>& high)
+	{
+		for (int c = 0; c < D; ++c) {
+			const double* x = batch.position[c];
+			auto range = std::minmax_element(x, x + batch.count);
+			low[c] = *range.first;
+			high[c] = *range.second;
+		}
+	}
+
+	template <int D, typename Potential>
+	void cellList(const ForceBatch& batch, const Potential& potential, double cutoff2)
+	{
+		const std::size_t n = batch.count;
+		const double cutoff = std::sqrt(cutoff2);
+		std::array<double, D> low;
+		std::array<double, D> high;
+		bounds<D>(batch, low, high);
+
+		// Cells at least `cutoff` wide, so interacting pairs are in neighbouring
+		// cells; no more cells than about 2 per particle
+		std::array<std::size_t, D> cells;
+		std::array<double, D> inverseWidth;
+		std::size_t total = 1;
+		for (int c = 0; c < D; ++c) {
+			const double extent = high[c] - low[c];
+			cells[c] = std::max<std::size_t>(1, static_cast<std::size_t>(extent / cutoff));
+		}
+		for (;;) {
+			total = 1;
+			for (int c = 0; c < D; ++c) {
+				total *= cells[c];
+			}
+			if (total <= 2 * n + 8) {
+				break;
+			}
+			auto widest = std::max_element(cells.begin(), cells.end());
+			*widest = (*widest + 1) / 2;
+		}
+		for (int c = 0; c < D; ++c) {
+			const double extent = high[c] - low[c];
+			inverseWidth[c] = extent > 0.0 ? static_cast<double>(cells[c]) / extent : 0.0;
+		}
+		auto cellCoordinate = [&](int c, double x) {
+			return std::min(cells[c] - 1, static_cast<std::size_t>((x - low[c]) * inverseWidth[c]));
+		};
+
+		// Counting sort of the particles by cell; positions and masses are
+		// copied in that order so each cell is a contiguous run
+		cellOf_.resize(n);
+		cellStart_.assign(total + 1, 0);
+		for (std::size_t i = 0; i < n; ++i) {
+			std::size_t cell = 0;
+			for (int c = D - 1; c >= 0; --c) {
+				cell = cell * cells[c] + cellCoordinate(c, batch.position[c][i]);
+			}
+			cellOf_[i] = static_cast<std::uint32_t>(cell);
+			++cellStart_[cell + 1];
+		}
+		for (std::size_t cell = 0; cell < total; ++cell) {
+			cellStart_[cell + 1] += cellStart_[cell];
+		}
+		order_.resize(n);
+		sorted_.resize(static_cast<std::size_t>(D + 1) * n);
+		{
+			std::vector<std::uint32_t>& fill = scratch_;
+			fill.assign(cellStart_.begin(), cellStart_.end() - 1);
+			for (std::size_t i = 0; i < n; ++i) {
+				const std::uint32_t k = fill[cellOf_[i]]++;
+				order_[k] = static_cast<std::uint32_t>(i);
+				for (int c = 0; c < D; ++c) {
+					sorted_[c * n + k] = batch.position[c][i];
+				}
+				sorted_[D * n + k] = batch.mass[i];
+			}
+		}
+
+		const double* sortedMass = sorted_.data() + D * n;
+		parallelFor(n, numThreads_, [&](std::size_t begin, std::size_t end) {
+			for (std::size_t k = begin; k < end; ++k) {
+				const std::size_t i = order_[k];
+				std::array<double, D> xi;
+				std::array<std::size_t, D> home;
+				std::array<double, D> acc{};
+				for (int c = 0; c < D; ++c) {
+					xi[c] = sorted_[c * n + k];
+					home[c] = cellCoordinate(c, xi[c]);
+				}
+				const double mi = sortedMass[k];
+				// Visit the 3^D cells around the particle's own
+				std::array<int, D> offset;
+				offset.fill(-1);
+				for (;;) {
+					bool inside = true;
+					std::size_t cell = 0;
+					for (int c = D - 1; c >= 0; --c) {
+						const long coordinate = static_cast<long>(home[c]) + offset[c];
+						inside = inside && coordinate >= 0 && coordinate < static_cast<long>(cells[c]);
+						cell = cell * cells[c] + static_cast<std::size_t>(coordinate);
+					}
+					if (inside) {
+						for (std::size_t kk = cellStart_[cell]; kk < cellStart_[cell + 1]; ++kk) {
+							std::array<double, D> d;
+							double r2 = 0.0;
+							for (int c = 0; c < D; ++c) {
+								d[c] = sorted_[c * n + kk] - xi[c];
+								r2 += d[c] * d[c];
+							}
+							if (kk == k || r2 >= cutoff2) {
+								continue;
+							}
+							const double s = potential.scale(r2, mi, sortedMass[kk]);
+							for (int c = 0; c < D; ++c) {
+								acc[c] += s * d[c];
+							}
+						}
+					}
+					int c = 0;
+					while (c < D && offset[c] == 1) {
+						offset[c++] = -1;
+					}
+					if (c == D) {
+						break;
+					}
+					++offset[c];
+				}
+				for (int c = 0; c < D; ++c) {
+					batch.force[c][i] += acc[c];
+				}
+			}
+		});
+	}
+
+	// Build the subtree of node `index` over order_[first, first + count)
+	template <int D>
+	void buildTree(const ForceBatch& batch, std::size_t index, int depth)
+	{
+		const std::uint32_t first = tree_[index].first;
+		const std::uint32_t count = tree_[index].count;
+		if (count <= leafSize || depth >= maxDepth) {
+			tree_[index].child = -1;
+			double mass = 0.0;
+			std::array<double, 3> moment{};
+			for (std::uint32_t k = first; k < first + count; ++k) {
+				const std::uint32_t j = order_[k];
+				mass += batch.mass[j];
+				for (int c = 0; c < D; ++c) {
+					moment[c] += batch.mass[j] * batch.position[c][j];
+				}
+			}
+			finishNode<D>(index, mass, moment);
+			return;
+		}
+
+		// Split the particles among the 2^D children (bit c of the child
+		// number set for the upper half along c)
+		const int children = 1 << D;
+		const double half = 0.5 * tree_[index].size;
+		std::array<double, D> middle;
+		for (int c = 0; c < D; ++c) {
+			middle[c] = tree_[index].low[c] + half;
+		}
+		std::array<std::uint32_t, 1 << D> start{};
+		for (std::uint32_t k = first; k < first + count; ++k) {
+			const std::uint32_t j = order_[k];
+			int octant = 0;
+			for (int c = 0; c < D; ++c) {
+				octant |= (batch.position[c][j] >= middle[c] ? 1 : 0) << c;
+			}
+			scratch_[k] = static_cast<std::uint32_t>(octant);
+			++start[octant];
+		}
+		std::uint32_t offset = first;
+		for (int o = 0; o < children; ++o) {
+			const std::uint32_t size = start[o];
+			start[o] = offset;
+			offset += size;
+		}
+		std::array<std::uint32_t, 1 << D> fill = start;
+		for (std::uint32_t k = first; k < first + count; ++k) {
+			treeOrder_[fill[scratch_[k]]++] = order_[k];
+		}
+		std::copy(treeOrder_.begin() + first, treeOrder_.begin() + first + count, order_.begin() + first);
+
+		const std::size_t child = tree_.size();
+		tree_[index].child = static_cast<std::int32_t>(child);
+		for (int o = 0; o < children; ++o) {
+			TreeNode node;
+			for (int c = 0; c < D; ++c) {
+				node.low[c] = tree_[index].low[c] + ((o >> c) & 1 ? half : 0.0);
+			}
+			node.size = half;
+			node.first = start[o];
+			node.count = fill[o] - start[o];
+			node.child = -1;
+			node.mass = 0.0;
+			tree_.push_back(node);
+		}
+		double mass = 0.0;
+		std::array<double, 3> moment{};
+		for (int o = 0; o < children; ++o) {
+			if (tree_[child + o].count > 0) {
+				buildTree<D>(batch, child + o, depth + 1);
+				mass += tree_[child + o].mass;
+				for (int c = 0; c < D; ++c) {
+					moment[c] += tree_[child + o].mass * tree_[child + o].center[c];
+				}
+			}
+		}
+		finishNode<D>(index, mass, moment);
+	}
+
+	// Centre of mass from the total mass and first moment
+	template <int D>
+	void finishNode(std::size_t index, double mass, const std::array<double, 3>& moment)
+	{
+		TreeNode& node = tree_[index];
+		node.mass = mass;
+		for (int c = 0; c < D; ++c) {
+			node.center[c] = mass != 0.0 ? moment[c] / mass : node.low[c] + 0.5 * node.size;
+		}
+	}
+
+	template <int D, typename Potential>
+	void barnesHut(const ForceBatch& batch, const Potential& potential)
+	{
+		const std::size_t n = batch.count;
+		std::array<double, D> low;
+		std::array<double, D> high;
+		bounds<D>(batch, low, high);
+		double size = 0.0;
+		for (int c = 0; c < D; ++c) {
+			size = std::max(size, high[c] - low[c]);
+		}
+		size = size > 0.0 ? size * (1.0 + 1e-9) : 1.0;
+
+		order_.resize(n);
+		treeOrder_.resize(n);
+		scratch_.resize(n);
+		for (std::size_t i = 0; i < n; ++i) {
+			order_[i] = static_cast<std::uint32_t>(i);
+		}
+		tree_.clear();
+		TreeNode root;
+		for (int c = 0; c < D; ++c) {
+			root.low[c] = low[c];
+		}
+		root.size = size;
+		root.first = 0;
+		root.count = static_cast<std::uint32_t>(n);
+		root.child = -1;
+		root.mass = 0.0;
+		tree_.push_back(root);
+		buildTree<D>(batch, 0, 0);
+
+		const double theta2 = theta2_;
+		parallelFor(n, numThreads_, [&](std::size_t begin, std::size_t end) {
+			std::array<std::uint32_t, maxDepth * (1 << D) + 1> stack;
+			for (std::size_t i = begin; i < end; ++i) {
+				std::array<double, D> xi;
+				std::array<double, D> acc{};
+				for (int c = 0; c < D; ++c) {
+					xi[c] = batch.position[c][i];
+				}
+				const double mi = batch.mass[i];
+				std::size_t top = 0;
+				stack[top++] = 0;
+				while (top > 0) {
+					const TreeNode& node = tree_[stack[--top]];
+					if (node.child < 0) {
+						for (std::uint32_t k = node.first; k < node.first + node.count; ++k) {
+							const std::uint32_t j = order_[k];
+							if (j == i) {
+								continue;
+							}
+							std::array<double, D> d;
+							double r2 = 0.0;
+							for (int c = 0; c < D; ++c) {
+								d[c] = batch.position[c][j] - xi[c];
+								r2 += d[c] * d[c];
+							}
+							const double s = potential.scale(r2, mi, batch.mass[j]);
+							for (int c = 0; c < D; ++c) {
+								acc[c] += s * d[c];
+							}
+						}
+						continue;
+					}
+					std::array<double, D> d;
+					double r2 = 0.0;
+					bool inside = true;
+					for (int c = 0; c < D; ++c) {
+						d[c] = node.center[c] - xi[c];
+						r2 += d[c] * d[c];
+						inside = inside && xi[c] >= node.low[c] && xi[c] <= node.low[c] + node.size;
+					}
+					// A far cell acts as one body; a cell holding particle i is always opened
+					if (!inside && node.size * node.size < theta2 * r2) {
+						const double s = potential.scale(r2, mi, node.mass);
+						for (int c = 0; c < D; ++c) {
+							acc[c] += s * d[c];
+						}
+					}
+					else {
+						for (int o = 0; o < (1 << D); ++o) {
+							if (tree_[node.child + o].count > 0) {
+								stack[top++] = static_cast<std::uint32_t>(node.child + o);
+							}
+						}
+					}
+				}
+				for (int c = 0; c < D; ++c) {
+					batch.force[c][i] += acc[c];
+				}
+			}
+		});
+	}
+
+	Kind kind_;
+	PairMethod method_;
+	unsigned numThreads_;
+	GravityPotential gravity_;
+	LennardJonesPotential lennardJones_;
+	double cutoff_;
+	double theta2_;
+
+	// Scratch reused between evaluations
+	std::vector<std::uint32_t> order_;     // particle indices sorted by cell / tree node
+	std::vector<std::uint32_t> treeOrder_;
+	std::vector<std::uint32_t> scratch_;
+	std::vector<std::uint32_t> cellOf_;
+	std::vector<std::uint32_t> cellStart_;
+	std::vector<double> sorted_;           // positions then masses, in cell order
+	std::vector<TreeNode> tree_;
+};
+
+#endif
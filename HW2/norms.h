@@ -0,0 +1,186 @@
+#ifndef NORMS_H
+#define NORMS_H
+
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <string>
+
+// Vector norms chosen at compile time, for single vectors and for batches.
+// Batches come in the two layouts used in this code:
+//   structure of arrays  x[c][i]        (ParticleSystem::position(c))
+//   packed               x[i * dim + c] (trajectory frames)
+// The structure-of-arrays kernels work on blocks of `normLanes` vectors at
+// a time: the inner loops have a fixed trip count and no dependence between
+// vectors, so the compiler turns them into SIMD instructions even at -O2,
+// one vector per SIMD lane.
+
+enum class NormType {
+	L1,  // sum of |x_c|
+	L2,  // sqrt of the sum of x_c^2
+	Linf // largest |x_c|
+};
+
+// "L1", "L2" or "Linf"
+inline NormType normType(const std::string& name)
+{
+	if (name == "L1") {
+		return NormType::L1;
+	}
+	else if (name == "L2") {
+		return NormType::L2;
+	}
+	else if (name == "Linf") {
+		return NormType::Linf;
+	}
+	throw std::invalid_argument("Unknown norm type");
+}
+
+// A norm as: acc = combine(acc, term(x_c)) over the components, then finish(acc)
+template <NormType T>
+struct NormOps;
+
+template <>
+struct NormOps<NormType::L1> {
+	static double term(double x) { return std::fabs(x); }
+	static double combine(double acc, double term) { return acc + term; }
+	static double finish(double acc) { return acc; }
+};
+
+template <>
+struct NormOps<NormType::L2> {
+	static double term(double x) { return x * x; }
+	static double combine(double acc, double term) { return acc + term; }
+	static double finish(double acc) { return std::sqrt(acc); }
+};
+
+template <>
+struct NormOps<NormType::Linf> {
+	static double term(double x) { return std::fabs(x); }
+	// Not std::max, so the comparison maps onto a SIMD max
+	static double combine(double acc, double term) { return term > acc ? term : acc; }
+	static double finish(double acc) { return acc; }
+};
+
+// Vectors per block of the batched kernels (8 doubles: two AVX or four SSE registers)
+const std::size_t normLanes = 8;
+
+// Norm of the n components x[0] .. x[n - 1]
+template <NormType T>
+double vectorNorm(const double* x, std::size_t n)
+{
+	typedef NormOps<T> Ops;
+	double acc = 0.0;
+	for (std::size_t c = 0; c < n; ++c) {
+		acc = Ops::combine(acc, Ops::term(x[c]));
+	}
+	return Ops::finish(acc);
+}
+
+// The same with the norm type chosen at run time
+inline double vectorNorm(NormType type, const double* x, std::size_t n)
+{
+	switch (type) {
+	case NormType::L1: return vectorNorm<NormType::L1>(x, n);
+	case NormType::L2: return vectorNorm<NormType::L2>(x, n);
+	default: return vectorNorm<NormType::Linf>(x, n);
+	}
+}
+
+// out[i] = norm of vector i of `count` vectors (structure of arrays: x[c][i])
+template <NormType T>
+void batchNorms(const double* const* x, int dimension, std::size_t count, double* out)
+{
+	typedef NormOps<T> Ops;
+	std::size_t i = 0;
+	for (; i + normLanes <= count; i += normLanes) {
+		double acc[normLanes] = {};
+		for (int c = 0; c < dimension; ++c) {
+			const double* __restrict xc = x[c] + i;
+			for (std::size_t l = 0; l < normLanes; ++l) {
+				acc[l] = Ops::combine(acc[l], Ops::term(xc[l]));
+			}
+		}
+		for (std::size_t l = 0; l < normLanes; ++l) {
+			out[i + l] = Ops::finish(acc[l]);
+		}
+	}
+	for (; i < count; ++i) {
+		double acc = 0.0;
+		for (int c = 0; c < dimension; ++c) {
+			acc = Ops::combine(acc, Ops::term(x[c][i]));
+		}
+		out[i] = Ops::finish(acc);
+	}
+}
+
+// out[i] = norm of vector i of `count` packed vectors (x[i * dimension + c]).
+// Vectors are taken one at a time: gathering blocks of them into SIMD lanes
+// measured slower than this plain loop (see bench_norms.cpp); convert to
+// the structure-of-arrays layout for SIMD.
+template <NormType T>
+void batchNorms(const double* x, int dimension, std::size_t count, double* out)
+{
+	const std::size_t d = static_cast<std::size_t>(dimension);
+	for (std::size_t i = 0; i < count; ++i) {
+		out[i] = vectorNorm<T>(x + i * d, d);
+	}
+}
+
+// out[i * countB + j] = norm of (b_j - a_i) for every a_i of `a` and b_j of `b`
+// (structure of arrays: a[c][i], b[c][j]); pass the same arrays twice for
+// the distances within one set
+template <NormType T>
+void pairwiseDistances(const double* const* a, std::size_t countA, const double* const* b, std::size_t countB,
+	int dimension, double* out)
+{
+	typedef NormOps<T> Ops;
+	for (std::size_t i = 0; i < countA; ++i) {
+		double* __restrict row = out + i * countB;
+		std::size_t j = 0;
+		for (; j + normLanes <= countB; j += normLanes) {
+			double acc[normLanes] = {};
+			for (int c = 0; c < dimension; ++c) {
+				const double ai = a[c][i];
+				const double* __restrict bc = b[c] + j;
+				for (std::size_t l = 0; l < normLanes; ++l) {
+					acc[l] = Ops::combine(acc[l], Ops::term(bc[l] - ai));
+				}
+			}
+			for (std::size_t l = 0; l < normLanes; ++l) {
+				row[j + l] = Ops::finish(acc[l]);
+			}
+		}
+		for (; j < countB; ++j) {
+			double acc = 0.0;
+			for (int c = 0; c < dimension; ++c) {
+				acc = Ops::combine(acc, Ops::term(b[c][j] - a[c][i]));
+			}
+			row[j] = Ops::finish(acc);
+		}
+	}
+}
+
+// The same for packed vectors (a[i * dimension + c], b[j * dimension + c]),
+// one pair at a time as for the packed batchNorms
+template <NormType T>
+void pairwiseDistances(const double* a, std::size_t countA, const double* b, std::size_t countB, int dimension,
+	double* out)
+{
+	typedef NormOps<T> Ops;
+	const std::size_t d = static_cast<std::size_t>(dimension);
+	for (std::size_t i = 0; i < countA; ++i) {
+		const double* ai = a + i * d;
+		double* __restrict row = out + i * countB;
+		for (std::size_t j = 0; j < countB; ++j) {
+			const double* bj = b + j * d;
+			double acc = 0.0;
+			for (std::size_t c = 0; c < d; ++c) {
+				acc = Ops::combine(acc, Ops::term(bj[c] - ai[c]));
+			}
+			row[j] = Ops::finish(acc);
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,49 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <thread>
+#include <vector>
+
+/**
+ * Run f(begin, end) over [0, count) on up to numThreads threads
+ * The range is cut into chunks handed out on demand, so uneven work
+ * (dense cells, deep tree branches) still balances. Chunks hold at least
+ * minChunk items, and a range of one chunk runs on the calling thread.
+ */
+template <typename F>
+void parallelFor(std::size_t count, unsigned numThreads, F f, std::size_t minChunk = 256)
+{
+	if (numThreads == 0) {
+		numThreads = std::max(1u, std::thread::hardware_concurrency());
+	}
+	numThreads = static_cast<unsigned>(std::min<std::size_t>(numThreads, (count + minChunk - 1) / minChunk));
+	if (numThreads <= 1) {
+		f(std::size_t(0), count);
+		return;
+	}
+	const std::size_t chunk = std::max(minChunk, count / (8 * static_cast<std::size_t>(numThreads)));
+	std::atomic<std::size_t> next(0);
+	auto worker = [&]() {
+		for (;;) {
+			const std::size_t begin = next.fetch_add(chunk);
+			if (begin >= count) {
+				break;
+			}
+			f(begin, std::min(count, begin + chunk));
+		}
+	};
+	std::vector<std::thread> threads;
+	threads.reserve(numThreads - 1);
+	for (unsigned t = 1; t < numThreads; ++t) {
+		threads.emplace_back(worker);
+	}
+	worker();
+	for (auto& thread : threads) {
+		thread.join();
+	}
+}
+
+#endif
@@ -0,0 +1,208 @@
+#ifndef PARTICLE_SYSTEM_H
+#define PARTICLE_SYSTEM_H
+
+#include <algorithm>
+#include <cmath>
+#include <cstddef>
+#include <stdexcept>
+#include <utility>
+#include <vector>
+
+#include "forces.h"
+#include "homework2_skeleton.cpp"
+
+// Make `v` hold `n` components (fixed-size vectors must already have n)
+inline void resizeComponents(Vector& v, size_t n)
+{
+	v.components_.resize(n);
+}
+
+template <size_t N>
+void resizeComponents(VectorN<N>&, size_t n)
+{
+	if (n != N) {
+		throw std::invalid_argument("Particle dimension does not match the system");
+	}
+}
+
+// Structure-of-arrays container for many particles of the same dimension.
+// Masses and each component of position, velocity and force live in their
+// own contiguous array, so a bulk update is a few straight loops over
+// doubles that the compiler vectorizes, instead of one call per particle
+// on separately allocated vectors.
+// Particles are copied in and out of the arrays with add(), load() and store().
+// Forces come from a list of kernels working on the whole arrays at once
+// (initially just sineForce, the sin(t + i) force of force(Vector&, double)).
+class ParticleSystem
+{
+public:
+	// Empty system of `dimension`-component particles
+	explicit ParticleSystem(int dimension, size_t capacity = 0)
+		: dimension_(dimension), position_(dimension), velocity_(dimension), force_(dimension),
+		  kernels_(1, ForceKernel(sineForce)), positionTable_(dimension), forceTable_(dimension)
+	{
+		if (dimension < 1) {
+			throw std::invalid_argument("ParticleSystem dimension must be positive");
+		}
+		reserve(capacity);
+	}
+
+	int dimension() const { return dimension_; }
+	size_t size() const { return mass_.size(); }
+
+	void reserve(size_t capacity)
+	{
+		mass_.reserve(capacity);
+		inverseMass_.reserve(capacity);
+		for (int c = 0; c < dimension_; ++c) {
+			position_[c].reserve(capacity);
+			velocity_[c].reserve(capacity);
+			force_[c].reserve(capacity);
+		}
+	}
+
+	// Append a particle at rest at the origin; returns its index
+	size_t add(double mass)
+	{
+		mass_.push_back(mass);
+		inverseMass_.push_back(1.0 / mass);
+		for (int c = 0; c < dimension_; ++c) {
+			position_[c].push_back(0.0);
+			velocity_[c].push_back(0.0);
+			force_[c].push_back(0.0);
+		}
+		return mass_.size() - 1;
+	}
+
+	// Append a copy of `particle`; returns its index
+	template <typename V>
+	size_t add(const BasicParticle<V>& particle)
+	{
+		size_t i = add(particle.mass_);
+		store(i, particle);
+		return i;
+	}
+
+	// Overwrite particle i with `particle` (same dimension)
+	template <typename V>
+	void store(size_t i, const BasicParticle<V>& particle)
+	{
+		if (particle.position_.size() != dimension_ || particle.velocity_.size() != dimension_
+			|| particle.force_.size() != dimension_) {
+			throw std::invalid_argument("Particle dimension does not match the system");
+		}
+		setMass(i, particle.mass_);
+		for (int c = 0; c < dimension_; ++c) {
+			position_[c][i] = particle.position_.components_[c];
+			velocity_[c][i] = particle.velocity_.components_[c];
+			force_[c][i] = particle.force_.components_[c];
+		}
+	}
+
+	// Copy particle i into `particle`, resizing runtime-size vectors as needed
+	template <typename V>
+	void load(size_t i, BasicParticle<V>& particle) const
+	{
+		resizeComponents(particle.position_, static_cast<size_t>(dimension_));
+		resizeComponents(particle.velocity_, static_cast<size_t>(dimension_));
+		resizeComponents(particle.force_, static_cast<size_t>(dimension_));
+		particle.mass_ = mass_[i];
+		for (int c = 0; c < dimension_; ++c) {
+			particle.position_.components_[c] = position_[c][i];
+			particle.velocity_.components_[c] = velocity_[c][i];
+			particle.force_.components_[c] = force_[c][i];
+		}
+	}
+
+	double mass(size_t i) const { return mass_[i]; }
+	void setMass(size_t i, double mass)
+	{
+		mass_[i] = mass;
+		inverseMass_[i] = 1.0 / mass;
+	}
+
+	// Contiguous arrays: masses, 1 / masses, and component c of every particle
+	const double* masses() const { return mass_.data(); }
+	const double* inverseMasses() const { return inverseMass_.data(); }
+	double* position(int c) { return position_[c].data(); }
+	const double* position(int c) const { return position_[c].data(); }
+	double* velocity(int c) { return velocity_[c].data(); }
+	const double* velocity(int c) const { return velocity_[c].data(); }
+	double* force(int c) { return force_[c].data(); }
+	const double* force(int c) const { return force_[c].data(); }
+
+	// Replace every force kernel by `kernel`
+	void setForce(ForceKernel kernel)
+	{
+		kernels_.assign(1, std::move(kernel));
+	}
+
+	// Add a force kernel; the forces of all kernels are summed
+	void addForce(ForceKernel kernel)
+	{
+		kernels_.push_back(std::move(kernel));
+	}
+
+	// Remove every force kernel (particles then move freely)
+	void clearForces()
+	{
+		kernels_.clear();
+	}
+
+	// Forces at time t on particles placed at `position` (one array of size()
+	// values per component), written to `force` (same layout): the sum of
+	// the force kernels, each called once for the whole system.
+	// Integrators call this with trial positions.
+	void evaluateForces(double t, const double* const* position, double* const* force) const
+	{
+		const size_t n = size();
+		for (int c = 0; c < dimension_; ++c) {
+			std::fill(force[c], force[c] + n, 0.0);
+		}
+		const ForceBatch batch = { t, n, dimension_, mass_.data(), position, force };
+		for (const ForceKernel& kernel : kernels_) {
+			kernel(batch);
+		}
+	}
+
+	// Set the force arrays to the forces at time t at the current positions
+	void computeForces(double t)
+	{
+		for (int c = 0; c < dimension_; ++c) {
+			positionTable_[c] = position_[c].data();
+			forceTable_[c] = force_[c].data();
+		}
+		evaluateForces(t, positionTable_.data(), forceTable_.data());
+	}
+
+	// Advance every particle from t to t + dt with the explicit Euler step of
+	// Particle::update; the results are bit-for-bit those of Particle::update
+	void update(double t, double dt)
+	{
+		computeForces(t);
+		const size_t n = size();
+		const double* __restrict inverseMass = inverseMass_.data();
+		for (int c = 0; c < dimension_; ++c) {
+			const double* __restrict f = force_[c].data();
+			double* __restrict v = velocity_[c].data();
+			double* __restrict x = position_[c].data();
+			for (size_t i = 0; i < n; ++i) {
+				v[i] = v[i] + (f[i] * inverseMass[i]) * dt;
+				x[i] = x[i] + v[i] * dt;
+			}
+		}
+	}
+
+private:
+	int dimension_;
+	vector<double> mass_;
+	vector<double> inverseMass_; // 1 / mass, kept in step with mass_
+	vector<vector<double>> position_;
+	vector<vector<double>> velocity_;
+	vector<vector<double>> force_;
+	vector<ForceKernel> kernels_;
+	vector<const double*> positionTable_; // component pointers for computeForces()
+	vector<double*> forceTable_;
+};
+
+#endif
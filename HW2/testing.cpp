@@ -4,9 +4,18 @@
 #include <cmath>
 #include <sstream>
 #include <cassert>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
 
 // Not a best practice
 #include "homework2_skeleton.cpp"
+#include "particle_system.h"
+#include "integrators.h"
+#include "nbody.h"
+#include "trajectory.h"
+#include "ensemble.h"
+#include "checkpoint.h"
 
 using namespace std;
 
@@ -214,6 +223,623 @@ assert(v6d.size() == 6);
 cout << "==> testMultiDimensionalVectors passed" << endl;
 }
 
+void testFixedVector()
+{
+Vector3 a(1.0, 2.0, 3.0);
+Vector3 b(4.0, 5.0, 6.0);
+assert(a + b == Vector3(5.0, 7.0, 9.0));
+assert(b - a == Vector3(3.0, 3.0, 3.0));
+assert((a ^ b) == Vector3(4.0, 10.0, 18.0));
+assert(2.0 * a == a * 2.0);
+assert(abs(a * b - 32.0) < 1e-9);
+assert(abs(a.norm(a, "L1") - 6.0) < 1e-9);
+Vector3 c(1.0 + 1e-10, 2.0, 3.0);
+assert(a == c);
+c.setTolerance(1e-12);
+a.setTolerance(1e-12);
+assert(a != c);
+
+// Round trip through the runtime-size Vector
+Vector v({1.0, 2.0, 3.0});
+assert(Vector3(v).toVector() == v);
+bool exception_thrown = false;
+try {
+Vector2 wrong(v);
+} catch (const std::invalid_argument& e) {
+exception_thrown = true;
+}
+assert(exception_thrown);
+
+std::stringstream ss;
+ss << Vector2(1.0, 2.0);
+assert(ss.str() == string("(1, 2)"));
+cout << "==> testFixedVector passed" << endl;
+}
+
+void testFixedParticle()
+{
+// Fixed-size and runtime-size particles follow the same trajectory
+Particle p(1.5, Vector(0.5, -0.5, 0.25), Vector(0.0, 0.0, 0.0), Vector(0.0, 0.0, 0.0));
+ParticleN<3> q(1.5, Vector3(0.5, -0.5, 0.25), Vector3(0.0, 0.0, 0.0), Vector3(0.0, 0.0, 0.0));
+for (int step = 0; step < 100; step++) {
+p.update(step * 0.02, 0.02);
+q.update(step * 0.02, 0.02);
+}
+for (int i = 0; i < 3; i++) {
+assert(p.position_[i] == q.position_[i]);
+assert(p.velocity_[i] == q.velocity_[i]);
+}
+cout << "==> testFixedParticle passed" << endl;
+}
+
+void testExpressionTemplates()
+{
+// A compound expression gives the same result as step-by-step evaluation
+Vector a({1.0, -2.0, 0.5, 4.0});
+Vector b({0.25, 3.0, -1.0, 2.0});
+Vector ab = a + b;
+Vector scaled = b * 0.5;
+Vector expected = ab - scaled;
+Vector result = a + b - b * 0.5;
+assert(result == expected);
+
+// The destination may appear in the expression
+Vector v({1.0, 2.0, 3.0, 4.0});
+v = v + v * 2.0;
+assert(v == Vector({3.0, 6.0, 9.0, 12.0}));
+v += a ^ b;
+assert(v == Vector({3.25, 0.0, 8.5, 20.0}));
+
+// Size mismatches are still reported inside a compound expression
+bool exception_thrown = false;
+try {
+Vector c = a + (b - Vector({1.0, 2.0}));
+} catch (const std::invalid_argument& e) {
+exception_thrown = true;
+}
+assert(exception_thrown);
+cout << "==> testExpressionTemplates passed" << endl;
+}
+
+void testParticleSystem()
+{
+// Bulk updates follow Particle::update exactly
+vector<Particle> particles;
+particles.reserve(3);
+particles.emplace_back(1.0, Vector(0.0, 0.0, 0.0), Vector(1.0, 0.0, 0.0), Vector(0.0, 0.0, 0.0));
+particles.emplace_back(2.5, Vector(1.0, -1.0, 0.5), Vector(0.0, 0.5, 0.0), Vector(0.0, 0.0, 0.0));
+particles.emplace_back(0.3, Vector(-2.0, 0.0, 1.0), Vector(0.0, 0.0, -1.0), Vector(0.0, 0.0, 0.0));
+ParticleSystem system(3);
+for (const auto& p : particles) {
+system.add(p);
+}
+assert(system.size() == 3);
+for (int step = 0; step < 50; step++) {
+for (auto& p : particles) {
+p.update(step * 0.02, 0.02);
+}
+system.update(step * 0.02, 0.02);
+}
+ParticleN<3> loaded(1.0, Vector3(), Vector3(), Vector3());
+for (size_t i = 0; i < particles.size(); i++) {
+system.load(i, loaded);
+assert(loaded.mass_ == particles[i].mass_);
+for (int c = 0; c < 3; c++) {
+assert(loaded.position_[c] == particles[i].position_[c]);
+assert(loaded.velocity_[c] == particles[i].velocity_[c]);
+}
+}
+
+// Particles of another dimension are rejected
+bool exception_thrown = false;
+try {
+system.add(Particle(1.0, Vector(0.0, 0.0), Vector(0.0, 0.0), Vector(0.0, 0.0)));
+} catch (const std::invalid_argument& e) {
+exception_thrown = true;
+}
+assert(exception_thrown);
+cout << "==> testParticleSystem passed" << endl;
+}
+
+void testIntegrators()
+{
+// The Euler integrator is Particle::update
+Particle p(2.0, Vector(0.5, -0.5), Vector(0.0, 1.0), Vector(0.0, 0.0));
+Particle q = p;
+EulerIntegrator euler;
+for (int step = 0; step < 20; step++) {
+p.update(step * 0.05, 0.05);
+euler.advance(q, step * 0.05, 0.05);
+}
+assert(p == q);
+
+// Higher orders land closer to the exact solution of x'' = sin(t + i) / m
+const double T = 2.0;
+const double exact = -0.5 + (T * cos(1.0) - sin(T + 1.0) + sin(1.0)) / 2.0; // x_1(T) from x_1(0) = -0.5, v(0) = 0
+double previous = 1.0;
+for (const char* type : { "euler", "verlet", "rk4", "rk45" }) {
+auto integrator = makeIntegrator(type);
+ParticleN<2> particle(2.0, Vector2(0.5, -0.5), Vector2(0.0, 0.0), Vector2(0.0, 0.0));
+for (int step = 0; step < 20; step++) {
+integrator->advance(particle, step * 0.1, 0.1);
+}
+double error = abs(particle.position_[1] - exact);
+assert(error < previous);
+previous = error;
+}
+assert(previous < 1e-8);
+
+// Particles stepped in turn through one integrator follow the same
+// trajectories as with one integrator each
+for (const char* type : { "euler", "verlet", "rk4", "rk45" }) {
+auto shared = makeIntegrator(type);
+auto ownA = makeIntegrator(type);
+auto ownB = makeIntegrator(type);
+ParticleN<2> a(1.0, Vector2(0.5, -0.5), Vector2(0.0, 0.0), Vector2(0.0, 0.0));
+ParticleN<2> b(4.0, Vector2(0.5, -0.5), Vector2(0.0, 0.0), Vector2(0.0, 0.0));
+ParticleN<2> a2 = a;
+ParticleN<2> b2 = b;
+for (int step = 0; step < 20; step++) {
+shared->advance(a, step * 0.1, 0.1);
+shared->advance(b, step * 0.1, 0.1);
+ownA->advance(a2, step * 0.1, 0.1);
+ownB->advance(b2, step * 0.1, 0.1);
+}
+for (int i = 0; i < 2; i++) {
+assert(a.position_[i] == a2.position_[i] && a.velocity_[i] == a2.velocity_[i]);
+assert(b.position_[i] == b2.position_[i] && b.velocity_[i] == b2.velocity_[i]);
+}
+}
+
+// Unknown names are rejected
+bool exception_thrown = false;
+try {
+makeIntegrator("leapfrog");
+} catch (const std::invalid_argument& e) {
+exception_thrown = true;
+}
+assert(exception_thrown);
+cout << "==> testIntegrators passed" << endl;
+}
+
+void testForceKernels()
+{
+// The angle-addition form of sin(t + i) agrees with std::sin
+for (double t : { 0.0, 0.37, 5.0, -12.5 }) {
+for (size_t i = 0; i < 80; i++) {
+assert(abs(sineForceComponent(t, sin(t), cos(t), i) - sin(t + i)) < 1e-14);
+}
+}
+
+// A custom kernel on contiguous arrays: unit springs, f = -k x.
+// With no other force, x(t) = x(0) cos(t) for k = m = 1.
+ParticleSystem springs(2);
+springs.add(1.0);
+springs.position(0)[0] = 1.0;
+springs.position(1)[0] = -0.5;
+springs.setForce([](const ForceBatch& batch) {
+for (int c = 0; c < batch.dimension; c++) {
+for (size_t i = 0; i < batch.count; i++) {
+batch.force[c][i] -= batch.position[c][i];
+}
+}
+});
+RK4Integrator rk4;
+for (int step = 0; step < 100; step++) {
+rk4.advance(springs, step * 0.01, 0.01);
+}
+assert(abs(springs.position(0)[0] - cos(1.0)) < 1e-9);
+assert(abs(springs.position(1)[0] + 0.5 * cos(1.0)) < 1e-9);
+
+// Kernels are summed: the sine force plus a constant pull of -sin(t + c)
+// cancel out, leaving the particle at rest
+ParticleSystem cancel(3);
+cancel.add(1.0);
+cancel.addForce([](const ForceBatch& batch) {
+for (int c = 0; c < batch.dimension; c++) {
+for (size_t i = 0; i < batch.count; i++) {
+batch.force[c][i] -= sin(batch.t + c);
+}
+}
+});
+cancel.update(0.3, 0.1);
+cancel.computeForces(1.1);
+for (int c = 0; c < 3; c++) {
+assert(abs(cancel.velocity(c)[0]) < 1e-15);
+assert(abs(cancel.force(c)[0]) < 1e-15);
+}
+cout << "==> testForceKernels passed" << endl;
+}
+
+void testPairForces()
+{
+// Two unit masses at unit distance attract with unit force
+ParticleSystem pair(3);
+pair.add(1.0);
+pair.add(1.0);
+pair.position(1)[1] = 1.0;
+pair.setForce(PairForce::gravity(1.0, 0.0, PairMethod::BruteForce));
+pair.computeForces(0.0);
+assert(abs(pair.force(1)[0] - 1.0) < 1e-12 && abs(pair.force(1)[1] + 1.0) < 1e-12);
+
+// The fast methods agree with brute force, in 2D and 3D, on any number of threads
+for (int dimension = 2; dimension <= 3; dimension++) {
+ParticleSystem cloud(dimension);
+unsigned state = 12345;
+for (int i = 0; i < 600; i++) {
+cloud.add(1.0 + (i % 3));
+for (int c = 0; c < dimension; c++) {
+state = state * 1103515245u + 12345u;
+cloud.position(c)[i] = 12.0 * ((state >> 8) & 0xffff) / 65536.0;
+}
+}
+ParticleSystem brute = cloud, tree = cloud, exactTree = cloud, ljBrute = cloud, cells = cloud, cellsThreaded = cloud;
+brute.setForce(PairForce::gravity(1.0, 0.01, PairMethod::BruteForce));
+tree.setForce(PairForce::gravity(1.0, 0.01, PairMethod::BarnesHut, 0.5, 1));
+exactTree.setForce(PairForce::gravity(1.0, 0.01, PairMethod::BarnesHut, 0.0, 3));
+ljBrute.setForce(PairForce::lennardJones(1.0, 0.5, 1.25, PairMethod::BruteForce));
+cells.setForce(PairForce::lennardJones(1.0, 0.5, 1.25, PairMethod::CellList, 1));
+cellsThreaded.setForce(PairForce::lennardJones(1.0, 0.5, 1.25, PairMethod::CellList, 3));
+for (ParticleSystem* system : { &brute, &tree, &exactTree, &ljBrute, &cells, &cellsThreaded }) {
+system->computeForces(0.0);
+}
+double difference = 0.0, norm = 0.0;
+for (int c = 0; c < dimension; c++) {
+for (int i = 0; i < 600; i++) {
+double g = brute.force(c)[i];
+assert(abs(exactTree.force(c)[i] - g) <= 1e-9 * (1.0 + abs(g)));
+difference += (tree.force(c)[i] - g) * (tree.force(c)[i] - g);
+norm += g * g;
+double lj = ljBrute.force(c)[i];
+assert(abs(cells.force(c)[i] - lj) <= 1e-9 * (1.0 + abs(lj)));
+assert(cellsThreaded.force(c)[i] == cells.force(c)[i]);
+}
+}
+// Opening angle 0.5 keeps the RMS error of the tree near 1e-3
+assert(sqrt(difference / norm) < 1e-2);
+}
+
+// Cell lists need a cutoff, Barnes-Hut a long-range force
+bool exception_thrown = false;
+try {
+PairForce::gravity(1.0, 0.0, PairMethod::CellList);
+} catch (const std::invalid_argument& e) {
+exception_thrown = true;
+}
+assert(exception_thrown);
+cout << "==> testPairForces passed" << endl;
+}
+
+void testTrajectory()
+{
+// Small buffers, so the writer thread gets many of them
+ParticleSystem system(3);
+system.add(1.0);
+system.add(2.0);
+{
+TrajectoryWriter writer("test_trajectory.traj", 3, 2, 3, 64);
+for (int step = 0; step < 100; step++) {
+writer.record(step * 0.01, system);
+system.update(step * 0.01, 0.01);
+}
+assert(writer.framesRecorded() == 34);
+writer.close();
+}
+// Every third step comes back exactly, particle by particle
+ParticleSystem replay(3);
+replay.add(1.0);
+replay.add(2.0);
+TrajectoryReader reader("test_trajectory.traj");
+assert(reader.dimension() == 3 && reader.particles() == 2 && reader.stride() == 3);
+double t = 0.0;
+vector<double> positions;
+size_t frames = 0;
+for (int step = 0; step < 100; step++) {
+if (step % 3 == 0) {
+assert(reader.next(t, positions));
+assert(t == step * 0.01 && positions.size() == 6);
+for (int i = 0; i < 2; i++) {
+for (int c = 0; c < 3; c++) {
+assert(positions[i * 3 + c] == replay.position(c)[i]);
+}
+}
+frames++;
+}
+replay.update(step * 0.01, 0.01);
+}
+assert(frames == 34 && !reader.next(t, positions));
+
+// One particle converts to the "time x y z" text format
+ParticleN<2> particle(1.0, Vector2(0.5, -0.5), Vector2(0.0, 0.0), Vector2(0.0, 0.0));
+{
+TrajectoryWriter writer("test_trajectory_2d.traj", 2);
+writer.record(0.0, particle);
+particle.update(0.0, 0.1);
+writer.record(0.1, particle);
+}
+assert(convertTrajectoryToText("test_trajectory_2d.traj", "test_trajectory_2d.txt") == 2);
+ifstream text("test_trajectory_2d.txt");
+string line;
+getline(text, line);
+assert(line == "time x y");
+getline(text, line);
+assert(line == "0 0.5 -0.5");
+remove("test_trajectory.traj");
+remove("test_trajectory_2d.traj");
+remove("test_trajectory_2d.txt");
+
+bool exception_thrown = false;
+try {
+TrajectoryWriter writer("test_trajectory.traj", 3, 1, 0);
+} catch (const std::invalid_argument& e) {
+exception_thrown = true;
+}
+assert(exception_thrown);
+remove("test_trajectory.traj");
+cout << "==> testTrajectory passed" << endl;
+}
+
+void testEnsemble()
+{
+// Without noise every realization moves by the same amount, so the mean
+// follows a single particle started at the mean and the variance is constant
+Ensemble ensemble(2, 5000, 42);
+ensemble.setBatchSize(700);
+ensemble.setThreads(1);
+EnsembleStatistics statistics = ensemble.run(0.05, 40);
+assert(statistics.realizations() == 5000 && statistics.steps() == 40);
+ParticleSystem reference(2);
+reference.add(1.0);
+for (int c = 0; c < 2; c++) {
+reference.position(c)[0] = statistics.mean(0, c);
+assert(abs(statistics.variance(0, c) - 1.0 / 3.0) < 0.02);
+}
+for (size_t k = 1; k <= 40; k++) {
+reference.update((k - 1) * 0.05, 0.05);
+for (int c = 0; c < 2; c++) {
+assert(abs(statistics.mean(k, c) - reference.position(c)[0]) < 1e-12);
+assert(abs(statistics.variance(k, c) - statistics.variance(0, c)) < 1e-12);
+}
+}
+
+// The statistics match a direct computation over the same random streams
+Ensemble small(1, 10, 7);
+small.setBatchSize(4);
+EnsembleStatistics direct = small.run(0.1, 0);
+vector<double> x;
+for (size_t b = 0; b < small.batches(); b++) {
+mt19937_64 rng = small.stream(b);
+ParticleSystem batch(1);
+for (size_t i = 0; i < min<size_t>(4, 10 - b * 4); i++) {
+batch.add(1.0);
+Ensemble::uniformStart(rng, batch, i);
+x.push_back(batch.position(0)[i]);
+}
+}
+double mean = 0.0, m2 = 0.0;
+for (double xi : x) mean += xi / 10.0;
+for (double xi : x) m2 += (xi - mean) * (xi - mean);
+assert(abs(direct.mean(0, 0) - mean) < 1e-14 && abs(direct.variance(0, 0) - m2 / 9.0) < 1e-14);
+
+// With noise the results depend only on the seed, not on the thread count,
+// and the velocity kicks spread the positions by about noise^2 t^3 / 3
+Ensemble noisy(3, 6000, 9);
+noisy.setNoise(0.5);
+noisy.setBatchSize(500);
+noisy.setThreads(1);
+EnsembleStatistics serial = noisy.run(0.01, 100);
+noisy.setThreads(3);
+EnsembleStatistics threaded = noisy.run(0.01, 100);
+for (int c = 0; c < 3; c++) {
+assert(threaded.mean(100, c) == serial.mean(100, c) && threaded.variance(100, c) == serial.variance(100, c));
+double spread = serial.variance(100, c) - serial.variance(0, c);
+assert(abs(spread - 0.25 / 3.0) < 0.02);
+}
+cout << "==> testEnsemble passed" << endl;
+}
+
+// Gravitating particles with random velocity kicks, stepped from `first` to
+// `last`, saving a checkpoint at step `save` when a writer is given
+void runNoisyGravity(ParticleSystem& system, Integrator& integrator, mt19937_64& rng,
+normal_distribution<double>& normal, size_t first, size_t last, CheckpointWriter* writer)
+{
+const double dt = 0.01;
+for (size_t step = first; step < last; step++) {
+if (writer != nullptr) {
+writer->maybeSave(step, step * dt, dt, system, &integrator, rng, normal);
+}
+integrator.advance(system, step * dt, dt);
+for (int c = 0; c < system.dimension(); c++) {
+system.velocity(c)[0] += 0.1 * normal(rng);
+}
+}
+}
+
+void testCheckpoint()
+{
+for (const char* type : { "euler", "verlet", "rk4", "rk45" }) {
+ParticleSystem system(3);
+mt19937_64 rng(11);
+normal_distribution<double> normal;
+uniform_real_distribution<double> dis(-1.0, 1.0);
+for (int i = 0; i < 20; i++) {
+system.add(1.0 + i % 4);
+for (int c = 0; c < 3; c++) {
+system.position(c)[i] = dis(rng);
+}
+}
+system.setForce(PairForce::gravity(1.0, 0.1, PairMethod::BruteForce, 0.5, 1));
+auto integrator = makeIntegrator(type);
+{
+CheckpointWriter writer("test_checkpoint.ckpt", 15);
+runNoisyGravity(system, *integrator, rng, normal, 0, 40, &writer);
+assert(writer.saved() == 3);
+writer.close();
+}
+
+// The last checkpoint (step 30) restarts into exactly the same state
+Checkpoint checkpoint = loadCheckpoint("test_checkpoint.ckpt");
+assert(checkpoint.step == 30 && checkpoint.particles() == 20 && checkpoint.dimension() == 3);
+ParticleSystem restarted(3);
+restarted.setForce(PairForce::gravity(1.0, 0.1, PairMethod::BruteForce, 0.5, 1));
+auto resumed = makeIntegrator(type);
+mt19937_64 restartedRng;
+normal_distribution<double> restartedNormal;
+checkpoint.restore(restarted, resumed.get());
+checkpoint.restoreRandom(restartedRng, restartedNormal);
+runNoisyGravity(restarted, *resumed, restartedRng, restartedNormal, checkpoint.step, 40, nullptr);
+for (int c = 0; c < 3; c++) {
+for (int i = 0; i < 20; i++) {
+assert(restarted.position(c)[i] == system.position(c)[i]);
+assert(restarted.velocity(c)[i] == system.velocity(c)[i]);
+}
+}
+assert(restarted.mass(3) == system.mass(3) && restartedRng() == rng());
+}
+remove("test_checkpoint.ckpt");
+
+bool exception_thrown = false;
+try {
+loadCheckpoint("test_checkpoint.ckpt");
+} catch (const std::invalid_argument& e) {
+exception_thrown = true;
+}
+assert(exception_thrown);
+
+// Corrupt sizes in the header are rejected before anything is allocated
+ParticleSystem small(2);
+small.add(1.0);
+small.add(2.0);
+Checkpoint saved;
+saved.capture(0, 0.0, 0.1, small);
+ostringstream out;
+saved.write(out);
+const string bytes = out.str();
+string hugeParticles = bytes;
+const uint64_t particles = uint64_t(1) << 60;
+memcpy(&hugeParticles[16], &particles, sizeof(particles));
+string hugeDimension = bytes;
+const uint32_t dimension = 1u << 30;
+memcpy(&hugeDimension[12], &dimension, sizeof(dimension));
+for (const string& corrupt : { hugeParticles, hugeDimension, bytes.substr(0, 60) }) {
+istringstream in(corrupt);
+Checkpoint loaded;
+exception_thrown = false;
+try {
+loaded.read(in);
+} catch (const std::invalid_argument& e) {
+exception_thrown = true;
+}
+assert(exception_thrown);
+}
+istringstream in(bytes);
+Checkpoint loaded;
+loaded.read(in);
+assert(loaded.particles() == 2 && loaded.dimension() == 2);
+
+// An ensemble run stopped after two batches and resumed from its saved
+// progress gives the statistics of an uninterrupted run, bit for bit
+Ensemble full(2, 2300, 11);
+full.setNoise(0.3);
+full.setBatchSize(500);
+full.setThreads(2);
+EnsembleStatistics uninterrupted = full.run(0.05, 20);
+Ensemble firstBatches(2, 1000, 11);
+firstBatches.setNoise(0.3);
+firstBatches.setBatchSize(500);
+full.saveProgress("test_ensemble.ckpt", EnsembleProgress{ 2, firstBatches.run(0.05, 20) });
+EnsembleStatistics resumed = full.resume(0.05, 20, full.loadProgress("test_ensemble.ckpt", 0.05, 20));
+assert(resumed.realizations() == 2300);
+for (size_t k = 0; k <= 20; k++) {
+for (int c = 0; c < 2; c++) {
+assert(resumed.mean(k, c) == uninterrupted.mean(k, c) && resumed.variance(k, c) == uninterrupted.variance(k, c));
+}
+}
+
+// A run with checkpoints leaves its final progress in the file
+full.setCheckpoint("test_ensemble.ckpt", 2);
+full.run(0.05, 20);
+EnsembleProgress progress = full.loadProgress("test_ensemble.ckpt", 0.05, 20);
+assert(progress.nextBatch == full.batches() && progress.statistics.realizations() == 2300);
+assert(progress.statistics.variance(20, 1) == uninterrupted.variance(20, 1));
+
+// Progress of a different ensemble or time step is rejected
+Ensemble otherSeed(2, 2300, 12);
+otherSeed.setNoise(0.3);
+otherSeed.setBatchSize(500);
+exception_thrown = false;
+try {
+otherSeed.loadProgress("test_ensemble.ckpt", 0.05, 20);
+} catch (const std::invalid_argument& e) {
+exception_thrown = true;
+}
+assert(exception_thrown);
+exception_thrown = false;
+try {
+full.loadProgress("test_ensemble.ckpt", 0.1, 20);
+} catch (const std::invalid_argument& e) {
+exception_thrown = true;
+}
+assert(exception_thrown);
+remove("test_ensemble.ckpt");
+cout << "==> testCheckpoint passed" << endl;
+}
+
+// Batched norms and distances against the single-vector norm
+template <NormType T>
+void checkNorms(const string& name)
+{
+const int dimension = 5;
+const size_t count = 21; // two full blocks and a remainder
+vector<double> packed(count * dimension);
+vector<vector<double>> columns(dimension, vector<double>(count));
+vector<const double*> soa(dimension);
+for (size_t i = 0; i < count; i++) {
+for (int c = 0; c < dimension; c++) {
+packed[i * dimension + c] = sin(1.7 * i + 0.3 * c) * (c + 1);
+columns[c][i] = packed[i * dimension + c];
+}
+}
+for (int c = 0; c < dimension; c++) {
+soa[c] = columns[c].data();
+}
+vector<double> fromColumns(count), fromPacked(count);
+batchNorms<T>(soa.data(), dimension, count, fromColumns.data());
+batchNorms<T>(packed.data(), dimension, count, fromPacked.data());
+vector<double> distances(count * count), packedDistances(count * count);
+pairwiseDistances<T>(soa.data(), count, soa.data(), count, dimension, distances.data());
+pairwiseDistances<T>(packed.data(), count, packed.data(), count, dimension, packedDistances.data());
+for (size_t i = 0; i < count; i++) {
+Vector v(vector<double>(packed.begin() + i * dimension, packed.begin() + (i + 1) * dimension));
+assert(abs(fromColumns[i] - v.norm(v, name)) < 1e-12);
+assert(fromPacked[i] == fromColumns[i]);
+for (size_t j = 0; j < count; j++) {
+Vector w(vector<double>(packed.begin() + j * dimension, packed.begin() + (j + 1) * dimension));
+Vector d = w - v;
+assert(abs(distances[i * count + j] - d.norm(d, name)) < 1e-12);
+assert(packedDistances[i * count + j] == distances[i * count + j]);
+}
+}
+}
+
+void testBatchNorms()
+{
+checkNorms<NormType::L1>("L1");
+checkNorms<NormType::L2>("L2");
+checkNorms<NormType::Linf>("Linf");
+Vector3 v(3.0, -4.0, 0.0);
+assert(v.norm(v, "L2") == 5.0 && vectorNorm<NormType::L1>(v.components_.data(), 3) == 7.0);
+
+bool exception_thrown = false;
+try {
+v.norm(v, "L3");
+} catch (const std::invalid_argument& e) {
+exception_thrown = true;
+}
+assert(exception_thrown);
+cout << "==> testBatchNorms passed" << endl;
+}
+
 //----------------------------------------------------------------------
 int main()
 {
@@ -233,6 +859,17 @@ testParticleSimulation();
 testErrorHandling();
 testDotProduct();
 testMultiDimensionalVectors();
+testFixedVector();
+testFixedParticle();
+testExpressionTemplates();
+testParticleSystem();
+testIntegrators();
+testForceKernels();
+testPairForces();
+testTrajectory();
+testEnsemble();
+testCheckpoint();
+testBatchNorms();
 
 cout << "\n=== ALL TESTS PASSED ===" << endl;
 }
@@ -0,0 +1,26 @@
+#include <iostream>
+#include <stdexcept>
+#include <string>
+
+#include "trajectory.h"
+
+using namespace std;
+
+// Convert a binary trajectory written by TrajectoryWriter to the
+// "time x y z" text format read by visualize_trajectories.py
+int main(int argc, char** argv)
+{
+	if (argc != 3) {
+		cerr << "Usage: " << argv[0] << " TRAJECTORY.traj OUTPUT.txt" << endl;
+		return 1;
+	}
+	try {
+		size_t frames = convertTrajectoryToText(argv[1], argv[2]);
+		cout << "Wrote " << frames << " frames to " << argv[2] << endl;
+	}
+	catch (const exception& e) {
+		cerr << e.what() << endl;
+		return 1;
+	}
+	return 0;
+}
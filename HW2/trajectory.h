@@ -0,0 +1,344 @@
+#ifndef TRAJECTORY_H
+#define TRAJECTORY_H
+
+#include <algorithm>
+#include <condition_variable>
+#include <cstdint>
+#include <cstring>
+#include <deque>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "particle_system.h"
+
+// Binary trajectory file: a header followed by fixed-size frames.
+//   header: magic "HW2TRAJ\0" (8 bytes), uint32 version, uint32 dimension,
+//           uint64 particles, uint64 stride (steps between saved frames)
+//   frame:  double time, then the positions particle by particle
+//           (x0 y0 z0 x1 y1 z1 ...), i.e. 1 + particles * dimension doubles
+// Numbers are stored in the machine's native byte order.
+struct TrajectoryHeader {
+	static const char* magic() { return "HW2TRAJ"; }
+	static const std::uint32_t currentVersion = 1;
+
+	std::uint32_t version = currentVersion;
+	std::uint32_t dimension = 0;
+	std::uint64_t particles = 0;
+	std::uint64_t stride = 1;
+
+	std::size_t frameDoubles() const { return 1 + static_cast<std::size_t>(particles) * dimension; }
+
+	void write(std::ostream& out) const
+	{
+		out.write(magic(), 8);
+		out.write(reinterpret_cast<const char*>(&version), sizeof(version));
+		out.write(reinterpret_cast<const char*>(&dimension), sizeof(dimension));
+		out.write(reinterpret_cast<const char*>(&particles), sizeof(particles));
+		out.write(reinterpret_cast<const char*>(&stride), sizeof(stride));
+	}
+
+	void read(std::istream& in)
+	{
+		char tag[8];
+		in.read(tag, 8);
+		in.read(reinterpret_cast<char*>(&version), sizeof(version));
+		in.read(reinterpret_cast<char*>(&dimension), sizeof(dimension));
+		in.read(reinterpret_cast<char*>(&particles), sizeof(particles));
+		in.read(reinterpret_cast<char*>(&stride), sizeof(stride));
+		if (!in || std::memcmp(tag, magic(), 8) != 0) {
+			throw std::invalid_argument("Not a trajectory file");
+		}
+		if (version != currentVersion) {
+			throw std::invalid_argument("Unsupported trajectory file version");
+		}
+	}
+};
+
+// Records trajectories to a binary file from a background thread.
+// record() copies the positions into the buffer being filled; a full buffer
+// is handed to the writer thread and the next one is taken from the buffers
+// it has finished writing. Normally two buffers alternate (one filling, one
+// being written); if the disk falls behind, another buffer is allocated
+// instead of waiting, so the computation never blocks on I/O. The only
+// synchronization on the compute side is a short lock to swap buffers.
+// With stride k only every k-th call of record() is kept (the first always is).
+class TrajectoryWriter
+{
+public:
+	TrajectoryWriter(const std::string& filename, int dimension, size_t particles = 1, size_t stride = 1,
+		size_t bufferBytes = 1 << 20)
+		: out_(filename, std::ios::binary)
+	{
+		if (dimension < 1 || particles < 1) {
+			throw std::invalid_argument("Trajectory dimension and particle count must be positive");
+		}
+		if (stride < 1) {
+			throw std::invalid_argument("Trajectory stride must be positive");
+		}
+		if (!out_) {
+			throw std::invalid_argument("Cannot open trajectory file " + filename);
+		}
+		header_.dimension = static_cast<std::uint32_t>(dimension);
+		header_.particles = particles;
+		header_.stride = stride;
+		header_.write(out_);
+		frameDoubles_ = header_.frameDoubles();
+		framesPerBuffer_ = std::max<size_t>(1, bufferBytes / (frameDoubles_ * sizeof(double)));
+		filling_ = newBuffer();
+		free_.push_back(newBuffer());
+		thread_ = std::thread(&TrajectoryWriter::run, this);
+	}
+
+	TrajectoryWriter(const TrajectoryWriter&) = delete;
+	TrajectoryWriter& operator=(const TrajectoryWriter&) = delete;
+
+	~TrajectoryWriter()
+	{
+		try {
+			close();
+		}
+		catch (...) {
+			// Destructors must not throw; call close() to see write errors
+		}
+	}
+
+	int dimension() const { return static_cast<int>(header_.dimension); }
+	size_t particles() const { return static_cast<size_t>(header_.particles); }
+	size_t stride() const { return static_cast<size_t>(header_.stride); }
+	size_t framesRecorded() const { return frames_; }
+	// Buffers allocated so far: 2 unless the writer thread fell behind
+	size_t buffersAllocated() const { return buffers_; }
+
+	// Record the positions of every particle of `system` at time t
+	void record(double t, const ParticleSystem& system)
+	{
+		if (system.dimension() != dimension() || system.size() != particles()) {
+			throw std::invalid_argument("System does not match the trajectory");
+		}
+		double* frame = nextFrame(t);
+		if (frame == nullptr) {
+			return;
+		}
+		const size_t n = particles();
+		for (int c = 0; c < dimension(); ++c) {
+			const double* x = system.position(c);
+			for (size_t i = 0; i < n; ++i) {
+				frame[i * header_.dimension + c] = x[i];
+			}
+		}
+	}
+
+	// Record the position of a single particle at time t
+	template <typename V>
+	void record(double t, const BasicParticle<V>& particle)
+	{
+		if (particle.position_.size() != dimension() || particles() != 1) {
+			throw std::invalid_argument("Particle does not match the trajectory");
+		}
+		double* frame = nextFrame(t);
+		if (frame == nullptr) {
+			return;
+		}
+		for (int c = 0; c < dimension(); ++c) {
+			frame[c] = particle.position_.components_[c];
+		}
+	}
+
+	// Write the remaining frames and wait for the writer thread; throws if
+	// a write failed. Further records are not allowed.
+	void close()
+	{
+		if (!thread_.joinable()) {
+			return;
+		}
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			if (!filling_->empty()) {
+				full_.push_back(std::move(filling_));
+			}
+			done_ = true;
+		}
+		ready_.notify_one();
+		thread_.join();
+		out_.close();
+		if (failed_) {
+			throw std::runtime_error("Failed to write the trajectory file");
+		}
+	}
+
+private:
+	using Buffer = std::unique_ptr<std::vector<double>>;
+
+	Buffer newBuffer()
+	{
+		++buffers_;
+		Buffer buffer(new std::vector<double>());
+		buffer->reserve(framesPerBuffer_ * frameDoubles_);
+		return buffer;
+	}
+
+	// Space for the frame of this call, or nullptr if the stride skips it
+	double* nextFrame(double t)
+	{
+		if (!thread_.joinable()) {
+			throw std::logic_error("Trajectory writer is closed");
+		}
+		if (calls_++ % header_.stride != 0) {
+			return nullptr;
+		}
+		if (filling_->size() == framesPerBuffer_ * frameDoubles_) {
+			handOff();
+		}
+		const size_t offset = filling_->size();
+		filling_->resize(offset + frameDoubles_);
+		(*filling_)[offset] = t;
+		++frames_;
+		return filling_->data() + offset + 1;
+	}
+
+	// Queue the full buffer and continue in a written (or new) one
+	void handOff()
+	{
+		Buffer next;
+		{
+			std::lock_guard<std::mutex> lock(mutex_);
+			full_.push_back(std::move(filling_));
+			if (!free_.empty()) {
+				next = std::move(free_.back());
+				free_.pop_back();
+			}
+		}
+		ready_.notify_one();
+		filling_ = next ? std::move(next) : newBuffer();
+	}
+
+	// Writer thread: write full buffers in order until closed
+	void run()
+	{
+		std::unique_lock<std::mutex> lock(mutex_);
+		for (;;) {
+			ready_.wait(lock, [this] { return done_ || !full_.empty(); });
+			if (full_.empty()) {
+				break;
+			}
+			Buffer buffer = std::move(full_.front());
+			full_.pop_front();
+			lock.unlock();
+			if (!failed_) {
+				out_.write(reinterpret_cast<const char*>(buffer->data()),
+					static_cast<std::streamsize>(buffer->size() * sizeof(double)));
+				failed_ = !out_;
+			}
+			buffer->clear();
+			lock.lock();
+			free_.push_back(std::move(buffer));
+		}
+		out_.flush();
+		failed_ = failed_ || !out_;
+	}
+
+	TrajectoryHeader header_;
+	std::ofstream out_;
+	size_t frameDoubles_ = 0;
+	size_t framesPerBuffer_ = 0;
+	size_t calls_ = 0;
+	size_t frames_ = 0;
+	size_t buffers_ = 0;
+	Buffer filling_;           // owned by the compute thread
+	std::deque<Buffer> full_;  // waiting to be written, oldest first
+	std::vector<Buffer> free_; // written and ready for reuse
+	std::mutex mutex_;
+	std::condition_variable ready_;
+	bool done_ = false;
+	bool failed_ = false;      // set by the writer thread, read after join
+	std::thread thread_;
+};
+
+// Reads the frames of a trajectory file one at a time
+class TrajectoryReader
+{
+public:
+	explicit TrajectoryReader(const std::string& filename)
+		: in_(filename, std::ios::binary)
+	{
+		if (!in_) {
+			throw std::invalid_argument("Cannot open trajectory file " + filename);
+		}
+		header_.read(in_);
+	}
+
+	const TrajectoryHeader& header() const { return header_; }
+	int dimension() const { return static_cast<int>(header_.dimension); }
+	size_t particles() const { return static_cast<size_t>(header_.particles); }
+	size_t stride() const { return static_cast<size_t>(header_.stride); }
+
+	// Read the next frame into t and positions (particle by particle);
+	// false at the end of the file. A truncated last frame is ignored.
+	bool next(double& t, std::vector<double>& positions)
+	{
+		frame_.resize(header_.frameDoubles());
+		in_.read(reinterpret_cast<char*>(frame_.data()),
+			static_cast<std::streamsize>(frame_.size() * sizeof(double)));
+		if (in_.gcount() != static_cast<std::streamsize>(frame_.size() * sizeof(double))) {
+			return false;
+		}
+		t = frame_[0];
+		positions.assign(frame_.begin() + 1, frame_.end());
+		return true;
+	}
+
+private:
+	std::ifstream in_;
+	TrajectoryHeader header_;
+	std::vector<double> frame_;
+};
+
+// Column names of the text format: x y z w u v for one particle, then c6,
+// c7, ...; with several particles the particle index is appended (x0 y0 x1 y1)
+inline std::string trajectoryColumn(size_t particle, size_t particles, int c)
+{
+	static const char* names[] = { "x", "y", "z", "w", "u", "v" };
+	std::string name = c < 6 ? names[c] : "c" + std::to_string(c);
+	return particles == 1 ? name : name + std::to_string(particle);
+}
+
+// Convert a binary trajectory to the text format written by main
+// ("time x y z" header, then one space-separated line per frame); returns
+// the number of frames
+inline size_t convertTrajectoryToText(const std::string& binaryFile, const std::string& textFile)
+{
+	TrajectoryReader reader(binaryFile);
+	std::ofstream out(textFile);
+	if (!out) {
+		throw std::invalid_argument("Cannot open text file " + textFile);
+	}
+	out << "time";
+	for (size_t i = 0; i < reader.particles(); ++i) {
+		for (int c = 0; c < reader.dimension(); ++c) {
+			out << " " << trajectoryColumn(i, reader.particles(), c);
+		}
+	}
+	out << "\n";
+	double t = 0.0;
+	std::vector<double> positions;
+	size_t frames = 0;
+	while (reader.next(t, positions)) {
+		out << t;
+		for (double x : positions) {
+			out << " " << x;
+		}
+		out << "\n";
+		++frames;
+	}
+	if (!out) {
+		throw std::runtime_error("Failed to write " + textFile);
+	}
+	return frames;
+}
+
+#endif
@@ -71,33 +71,6 @@ void Grid1D::set(int i, int j, int k, double value) {
     data[i * ny * nz + j * nz + k] = value;
 }
 
-// Addition operator
-Grid1D Grid1D::operator+(const Grid1D& grid) const {
-    if (nx != grid.nx || ny != grid.ny || nz != grid.nz) {
-        throw std::invalid_argument("Grid dimensions must match for addition");
-    }
-    
-    Grid1D result(nx, ny, nz);
-    for (int i = 0; i < nx * ny * nz; i++) {
-        result.data[i] = data[i] + grid.data[i];
-    }
-    return result;
-}
-
-// Multiplication by scalar (member function)
-Grid1D Grid1D::operator*(double factor) const {
-    Grid1D result(nx, ny, nz);
-    for (int i = 0; i < nx * ny * nz; i++) {
-        result.data[i] = data[i] * factor;
-    }
-    return result;
-}
-
-// Multiplication by scalar (friend function)
-Grid1D operator*(double factor, const Grid1D& grid) {
-    return grid * factor;
-}
-
 // Prefix increment: increment every element by 1
 Grid1D& Grid1D::operator++() {
     for (int i = 0; i < nx * ny * nz; i++) {
@@ -11,7 +11,9 @@ Method 1)
 
 #include <iostream>
 
-class Grid1D {
+#include "grid3d_expr.h"
+
+class Grid1D : public GridExpr<Grid1D> {
 public:
     Grid1D(int nx_, int ny_, int nz_);
     ~Grid1D();
@@ -24,17 +26,65 @@ public:
     // Set a value. Using operator() is more elegant, but requires
     // more knowledge to implement
     void set(int i, int j, int k, double value);
-    Grid1D operator+(const Grid1D& grid) const;
-    Grid1D operator*(double factor) const;
-    friend Grid1D operator*(double factor, const Grid1D& grid);
     // Prefix increment: increment every element in the grid by 1
     Grid1D& operator++();
     Grid1D& operator+=(const Grid1D& grid);
+    template <class E>
+    Grid1D& operator+=(const GridExpr<E>& expr);
     friend std::ostream& operator<<(std::ostream& os, const Grid1D& grid);
 
+    // Arithmetic (+, -, *, / with grids and scalars) builds expressions, see
+    // grid3d_expr.h; these evaluate one into the grid in a single pass
+    template <class E>
+    Grid1D(const GridExpr<E>& expr);
+    template <class E>
+    Grid1D& operator=(const GridExpr<E>& expr);
+
+    // Expression interface
+    typedef const double* Pencil;
+    static const bool contiguous = true;
+    int getNx() const { return nx; }
+    int getNy() const { return ny; }
+    int getNz() const { return nz; }
+    Pencil pencil(int i, int j) const { return data + (i * ny + j) * nz; }
+
 private:
+    template <class Store, class Grid, class E>
+    friend void evaluateGrid(Grid& grid, const E& expr);
+    double* output(int i, int j) { return data + (i * ny + j) * nz; }
+
     double* data;
     int nx, ny, nz;
 };
 
+template <class E>
+Grid1D::Grid1D(const GridExpr<E>& expr)
+    : nx(expr.self().getNx()), ny(expr.self().getNy()), nz(expr.self().getNz()) {
+    data = new double[nx * ny * nz];
+    evaluateGrid<GridStore>(*this, expr.self());
+}
+
+template <class E>
+Grid1D& Grid1D::operator=(const GridExpr<E>& expr) {
+    const E& e = expr.self();
+    // An expression with other dimensions cannot refer to this grid, so the
+    // old values can be dropped before evaluating it
+    if (nx != e.getNx() || ny != e.getNy() || nz != e.getNz()) {
+        delete[] data;
+        nx = e.getNx();
+        ny = e.getNy();
+        nz = e.getNz();
+        data = new double[nx * ny * nz];
+    }
+    evaluateGrid<GridStore>(*this, e);
+    return *this;
+}
+
+template <class E>
+Grid1D& Grid1D::operator+=(const GridExpr<E>& expr) {
+    checkGridDimensions(*this, expr.self(), "addition");
+    evaluateGrid<GridAddStore>(*this, expr.self());
+    return *this;
+}
+
 #endif
@@ -0,0 +1,266 @@
+/*
+Expression templates for the grid classes.
+
+grid1 + grid2 * 3.0 does not compute anything: the operators build a small
+expression object that refers to the grids and remembers the operations.
+The work is done when the expression is given to a grid (constructor,
+assignment or +=), in one pass over the elements, so no temporary grid is
+ever allocated however long the expression.
+
+Every expression E (the grids included) provides:
+    getNx(), getNy(), getNz()   dimensions
+    E::Pencil pencil(i, j)      the nz values at (i, j, 0 .. nz-1), read as p[k]
+    E::contiguous               true if pencil(0, 0) reads all nx*ny*nz values
+                                in order (k fastest), as for Grid1D and GridNew
+
+Expressions hold references to the grids they use, so evaluate them before
+the grids go away (do not keep one in an `auto` variable).
+*/
+
+#ifndef __GRID3D_EXPR_H__
+#define __GRID3D_EXPR_H__
+
+#include <stdexcept>
+#include <string>
+
+class Grid1D;
+class GridVec;
+class GridNew;
+
+// Base of every expression, the grids included (E is the derived class)
+template <class E>
+class GridExpr {
+public:
+    const E& self() const { return static_cast<const E&>(*this); }
+
+    // Value at (i, j, k), computed on demand
+    double operator()(int i, int j, int k) const {
+        const E& e = self();
+        if (i < 0 || i >= e.getNx() || j < 0 || j >= e.getNy() || k < 0 || k >= e.getNz()) {
+            throw std::out_of_range("Index out of bounds");
+        }
+        return e.pencil(i, j)[k];
+    }
+};
+
+// How an expression holds its operands: grids by reference, expressions by
+// value (they are small and usually temporaries)
+template <class E>
+struct GridOperand {
+    typedef E type;
+};
+
+template <>
+struct GridOperand<Grid1D> {
+    typedef const Grid1D& type;
+};
+
+template <>
+struct GridOperand<GridVec> {
+    typedef const GridVec& type;
+};
+
+template <>
+struct GridOperand<GridNew> {
+    typedef const GridNew& type;
+};
+
+// Element-wise operations
+struct GridAdd {
+    static const char* name() { return "addition"; }
+    static double apply(double a, double b) { return a + b; }
+};
+
+struct GridSubtract {
+    static const char* name() { return "subtraction"; }
+    static double apply(double a, double b) { return a - b; }
+};
+
+struct GridMultiply {
+    static const char* name() { return "multiplication"; }
+    static double apply(double a, double b) { return a * b; }
+};
+
+struct GridDivide {
+    static const char* name() { return "division"; }
+    static double apply(double a, double b) { return a / b; }
+};
+
+// The scalar on the left: scalar - grid, scalar / grid
+template <class Op>
+struct GridSwapped {
+    static double apply(double a, double b) { return Op::apply(b, a); }
+};
+
+template <class A, class B>
+void checkGridDimensions(const A& a, const B& b, const char* operation) {
+    if (a.getNx() != b.getNx() || a.getNy() != b.getNy() || a.getNz() != b.getNz()) {
+        throw std::invalid_argument(std::string("Grid dimensions must match for ") + operation);
+    }
+}
+
+// l op r, element by element
+template <class Op, class L, class R>
+class GridBinaryExpr : public GridExpr<GridBinaryExpr<Op, L, R> > {
+public:
+    struct Pencil {
+        typename L::Pencil l;
+        typename R::Pencil r;
+        double operator[](int k) const { return Op::apply(l[k], r[k]); }
+    };
+
+    static const bool contiguous = L::contiguous && R::contiguous;
+
+    GridBinaryExpr(const L& l_, const R& r_) : l(l_), r(r_) {
+        checkGridDimensions(l, r, Op::name());
+    }
+
+    int getNx() const { return l.getNx(); }
+    int getNy() const { return l.getNy(); }
+    int getNz() const { return l.getNz(); }
+
+    Pencil pencil(int i, int j) const {
+        Pencil p = { l.pencil(i, j), r.pencil(i, j) };
+        return p;
+    }
+
+private:
+    typename GridOperand<L>::type l;
+    typename GridOperand<R>::type r;
+};
+
+// e op scalar, element by element
+template <class Op, class E>
+class GridScalarExpr : public GridExpr<GridScalarExpr<Op, E> > {
+public:
+    struct Pencil {
+        typename E::Pencil e;
+        double scalar;
+        double operator[](int k) const { return Op::apply(e[k], scalar); }
+    };
+
+    static const bool contiguous = E::contiguous;
+
+    GridScalarExpr(const E& e_, double scalar_) : e(e_), scalar(scalar_) {}
+
+    int getNx() const { return e.getNx(); }
+    int getNy() const { return e.getNy(); }
+    int getNz() const { return e.getNz(); }
+
+    Pencil pencil(int i, int j) const {
+        Pencil p = { e.pencil(i, j), scalar };
+        return p;
+    }
+
+private:
+    typename GridOperand<E>::type e;
+    double scalar;
+};
+
+// Grid with grid
+template <class L, class R>
+GridBinaryExpr<GridAdd, L, R> operator+(const GridExpr<L>& l, const GridExpr<R>& r) {
+    return GridBinaryExpr<GridAdd, L, R>(l.self(), r.self());
+}
+
+template <class L, class R>
+GridBinaryExpr<GridSubtract, L, R> operator-(const GridExpr<L>& l, const GridExpr<R>& r) {
+    return GridBinaryExpr<GridSubtract, L, R>(l.self(), r.self());
+}
+
+template <class L, class R>
+GridBinaryExpr<GridMultiply, L, R> operator*(const GridExpr<L>& l, const GridExpr<R>& r) {
+    return GridBinaryExpr<GridMultiply, L, R>(l.self(), r.self());
+}
+
+template <class L, class R>
+GridBinaryExpr<GridDivide, L, R> operator/(const GridExpr<L>& l, const GridExpr<R>& r) {
+    return GridBinaryExpr<GridDivide, L, R>(l.self(), r.self());
+}
+
+// Grid with scalar
+template <class E>
+GridScalarExpr<GridAdd, E> operator+(const GridExpr<E>& e, double s) {
+    return GridScalarExpr<GridAdd, E>(e.self(), s);
+}
+
+template <class E>
+GridScalarExpr<GridAdd, E> operator+(double s, const GridExpr<E>& e) {
+    return GridScalarExpr<GridAdd, E>(e.self(), s);
+}
+
+template <class E>
+GridScalarExpr<GridSubtract, E> operator-(const GridExpr<E>& e, double s) {
+    return GridScalarExpr<GridSubtract, E>(e.self(), s);
+}
+
+template <class E>
+GridScalarExpr<GridSwapped<GridSubtract>, E> operator-(double s, const GridExpr<E>& e) {
+    return GridScalarExpr<GridSwapped<GridSubtract>, E>(e.self(), s);
+}
+
+template <class E>
+GridScalarExpr<GridMultiply, E> operator*(const GridExpr<E>& e, double s) {
+    return GridScalarExpr<GridMultiply, E>(e.self(), s);
+}
+
+template <class E>
+GridScalarExpr<GridMultiply, E> operator*(double s, const GridExpr<E>& e) {
+    return GridScalarExpr<GridMultiply, E>(e.self(), s);
+}
+
+template <class E>
+GridScalarExpr<GridDivide, E> operator/(const GridExpr<E>& e, double s) {
+    return GridScalarExpr<GridDivide, E>(e.self(), s);
+}
+
+template <class E>
+GridScalarExpr<GridSwapped<GridDivide>, E> operator/(double s, const GridExpr<E>& e) {
+    return GridScalarExpr<GridSwapped<GridDivide>, E>(e.self(), s);
+}
+
+template <class E>
+GridScalarExpr<GridMultiply, E> operator-(const GridExpr<E>& e) {
+    return GridScalarExpr<GridMultiply, E>(e.self(), -1.0);
+}
+
+// How a computed value is stored into the destination
+struct GridStore {
+    static void apply(double& out, double value) { out = value; }
+};
+
+struct GridAddStore {
+    static void apply(double& out, double value) { out += value; }
+};
+
+// The one pass over the elements: store expr into grid, which must have the
+// same dimensions. The grid provides double* output(i, j) for its pencils.
+// Reading and writing the same element together is safe, so the grid may
+// appear in the expression (grid = grid * 2.0 + other).
+template <class Store, class Grid, class E>
+void evaluateGrid(Grid& grid, const E& expr) {
+    const int nx = grid.getNx(), ny = grid.getNy(), nz = grid.getNz();
+    if (nx * ny * nz == 0) {
+        return;
+    }
+    if (Grid::contiguous && E::contiguous) {
+        const int n = nx * ny * nz;
+        double* out = grid.output(0, 0);
+        typename E::Pencil in = expr.pencil(0, 0);
+        for (int m = 0; m < n; m++) {
+            Store::apply(out[m], in[m]);
+        }
+        return;
+    }
+    for (int i = 0; i < nx; i++) {
+        for (int j = 0; j < ny; j++) {
+            double* out = grid.output(i, j);
+            typename E::Pencil in = expr.pencil(i, j);
+            for (int k = 0; k < nz; k++) {
+                Store::apply(out[k], in[k]);
+            }
+        }
+    }
+}
+
+#endif
@@ -1,86 +1,63 @@
 ﻿#include "grid3d_new.h"
+#include <algorithm>
+#include <cstring>
 #include <stdexcept>
 
-// Constructor: allocate memory using new
-GridNew::GridNew(int nx_, int ny_, int nz_) : nx(nx_), ny(ny_), nz(nz_) {
-    // Allocate 3D array using new
+// Allocate the slab and build the pointer tables into it: three
+// allocations whatever the size, instead of one per (i,j) pencil
+void GridNew::allocate() {
+    slab = new double[nx * ny * nz];
+    rows = new double*[nx * ny];
     data = new double**[nx];
     for (int i = 0; i < nx; i++) {
-        data[i] = new double*[ny];
+        data[i] = rows + i * ny;
         for (int j = 0; j < ny; j++) {
-            data[i][j] = new double[nz];
-            // Initialize to 0
-            for (int k = 0; k < nz; k++) {
-                data[i][j][k] = 0.0;
-            }
+            data[i][j] = slab + (i * ny + j) * nz;
         }
     }
 }
 
+// Free the slab and the pointer tables
+void GridNew::release() {
+    delete[] data;
+    delete[] rows;
+    delete[] slab;
+    data = nullptr;
+    rows = nullptr;
+    slab = nullptr;
+}
+
+// Constructor: allocate memory using new
+GridNew::GridNew(int nx_, int ny_, int nz_) : nx(nx_), ny(ny_), nz(nz_) {
+    allocate();
+    // Initialize to 0
+    std::fill(slab, slab + nx * ny * nz, 0.0);
+}
+
 // Destructor: free allocated memory
 GridNew::~GridNew() {
-    if (data != nullptr) {
-        for (int i = 0; i < nx; i++) {
-            if (data[i] != nullptr) {
-                for (int j = 0; j < ny; j++) {
-                    delete[] data[i][j];
-                }
-                delete[] data[i];
-            }
-        }
-        delete[] data;
-        data = nullptr;
-    }
+    release();
 }
 
 // Copy constructor
 GridNew::GridNew(const GridNew& grid) : nx(grid.nx), ny(grid.ny), nz(grid.nz) {
-    // Allocate new memory
-    data = new double**[nx];
-    for (int i = 0; i < nx; i++) {
-        data[i] = new double*[ny];
-        for (int j = 0; j < ny; j++) {
-            data[i][j] = new double[nz];
-            // Copy data
-            for (int k = 0; k < nz; k++) {
-                data[i][j][k] = grid.data[i][j][k];
-            }
-        }
-    }
+    allocate();
+    // Copy data in one block
+    std::memcpy(slab, grid.slab, sizeof(double) * nx * ny * nz);
 }
 
 // Assignment operator
 GridNew& GridNew::operator=(const GridNew& grid) {
     if (this != &grid) { // Check for self-assignment
-        // Free existing memory
-        if (data != nullptr) {
-            for (int i = 0; i < nx; i++) {
-                if (data[i] != nullptr) {
-                    for (int j = 0; j < ny; j++) {
-                        delete[] data[i][j];
-                    }
-                    delete[] data[i];
-                }
-            }
-            delete[] data;
-        }
-        
-        // Copy dimensions
-        nx = grid.nx;
-        ny = grid.ny;
-        nz = grid.nz;
-        
-        // Allocate new memory and copy data
-        data = new double**[nx];
-        for (int i = 0; i < nx; i++) {
-            data[i] = new double*[ny];
-            for (int j = 0; j < ny; j++) {
-                data[i][j] = new double[nz];
-                for (int k = 0; k < nz; k++) {
-                    data[i][j][k] = grid.data[i][j][k];
-                }
-            }
+        // Reallocate only if the dimensions change
+        if (nx != grid.nx || ny != grid.ny || nz != grid.nz) {
+            release();
+            nx = grid.nx;
+            ny = grid.ny;
+            nz = grid.nz;
+            allocate();
         }
+        std::memcpy(slab, grid.slab, sizeof(double) * nx * ny * nz);
     }
     return *this;
 }
@@ -115,49 +92,11 @@ void GridNew::set(int i, int j, int k, double value) {
     data[i][j][k] = value;
 }
 
-// Addition operator
-GridNew GridNew::operator+(const GridNew& grid) const {
-    if (nx != grid.nx || ny != grid.ny || nz != grid.nz) {
-        throw std::invalid_argument("Grid dimensions must match for addition");
-    }
-    
-    GridNew result(nx, ny, nz);
-    for (int i = 0; i < nx; i++) {
-        for (int j = 0; j < ny; j++) {
-            for (int k = 0; k < nz; k++) {
-                result.data[i][j][k] = data[i][j][k] + grid.data[i][j][k];
-            }
-        }
-    }
-    return result;
-}
-
-// Multiplication by scalar (member function)
-GridNew GridNew::operator*(double factor) const {
-    GridNew result(nx, ny, nz);
-    for (int i = 0; i < nx; i++) {
-        for (int j = 0; j < ny; j++) {
-            for (int k = 0; k < nz; k++) {
-                result.data[i][j][k] = data[i][j][k] * factor;
-            }
-        }
-    }
-    return result;
-}
-
-// Multiplication by scalar (friend function)
-GridNew operator*(double factor, const GridNew& grid) {
-    return grid * factor;
-}
-
 // Prefix increment: increment every element by 1
 GridNew& GridNew::operator++() {
-    for (int i = 0; i < nx; i++) {
-        for (int j = 0; j < ny; j++) {
-            for (int k = 0; k < nz; k++) {
-                data[i][j][k] += 1.0;
-            }
-        }
+    const int n = nx * ny * nz;
+    for (int m = 0; m < n; m++) {
+        slab[m] += 1.0;
     }
     return *this;
 }
@@ -168,12 +107,9 @@ GridNew& GridNew::operator+=(const GridNew& grid) {
         throw std::invalid_argument("Grid dimensions must match for addition");
     }
     
-    for (int i = 0; i < nx; i++) {
-        for (int j = 0; j < ny; j++) {
-            for (int k = 0; k < nz; k++) {
-                data[i][j][k] += grid.data[i][j][k];
-            }
-        }
+    const int n = nx * ny * nz;
+    for (int m = 0; m < n; m++) {
+        slab[m] += grid.slab[m];
     }
     return *this;
 }
@@ -12,7 +12,9 @@ Method 1)
 
 #include <iostream>
 
-class GridNew {
+#include "grid3d_expr.h"
+
+class GridNew : public GridExpr<GridNew> {
 public:
     GridNew(int nx_ = 1, int ny_ = 1, int nz_ = 1);
     ~GridNew();
@@ -25,16 +27,71 @@ public:
     // Set a value. Using operator() is more elegant, but requires
     // more knowledge to implement
     void set(int i, int j, int k, double value);
-    GridNew operator+(const GridNew& grid) const;
-    GridNew operator*(double factor) const;
-    friend GridNew operator*(double factor, const GridNew& grid);
     GridNew& operator++();
     GridNew& operator+=(const GridNew& grid);
+    template <class E>
+    GridNew& operator+=(const GridExpr<E>& expr);
     friend std::ostream& operator<<(std::ostream& os, const GridNew& grid);
 
+    // Arithmetic (+, -, *, / with grids and scalars) builds expressions, see
+    // grid3d_expr.h; these evaluate one into the grid in a single pass
+    template <class E>
+    GridNew(const GridExpr<E>& expr);
+    template <class E>
+    GridNew& operator=(const GridExpr<E>& expr);
+
+    // Expression interface
+    typedef const double* Pencil;
+    static const bool contiguous = true;
+    int getNx() const { return nx; }
+    int getNy() const { return ny; }
+    int getNz() const { return nz; }
+    Pencil pencil(int i, int j) const { return data[i][j]; }
+
 private:
-    double*** data;
+    template <class Store, class Grid, class E>
+    friend void evaluateGrid(Grid& grid, const E& expr);
+    double* output(int i, int j) { return data[i][j]; }
+
+    // One contiguous slab of nx*ny*nz values (k fastest), with pointer
+    // tables so that data[i][j][k] still indexes it
+    void allocate();
+    void release();
+
+    double*** data;  // data[i] = rows + i*ny
+    double** rows;   // rows[i*ny + j] = slab + (i*ny + j)*nz
+    double* slab;
     int nx, ny, nz;
 };
 
+template <class E>
+GridNew::GridNew(const GridExpr<E>& expr)
+    : nx(expr.self().getNx()), ny(expr.self().getNy()), nz(expr.self().getNz()) {
+    allocate();
+    evaluateGrid<GridStore>(*this, expr.self());
+}
+
+template <class E>
+GridNew& GridNew::operator=(const GridExpr<E>& expr) {
+    const E& e = expr.self();
+    // An expression with other dimensions cannot refer to this grid, so the
+    // old values can be dropped before evaluating it
+    if (nx != e.getNx() || ny != e.getNy() || nz != e.getNz()) {
+        release();
+        nx = e.getNx();
+        ny = e.getNy();
+        nz = e.getNz();
+        allocate();
+    }
+    evaluateGrid<GridStore>(*this, e);
+    return *this;
+}
+
+template <class E>
+GridNew& GridNew::operator+=(const GridExpr<E>& expr) {
+    checkGridDimensions(*this, expr.self(), "addition");
+    evaluateGrid<GridAddStore>(*this, expr.self());
+    return *this;
+}
+
 #endif
@@ -63,41 +63,6 @@ void GridVec::set(int i, int j, int k, double value) {
     data[i][j][k] = value;
 }
 
-// Addition operator
-GridVec GridVec::operator+(const GridVec& grid) const {
-    if (nx != grid.nx || ny != grid.ny || nz != grid.nz) {
-        throw std::invalid_argument("Grid dimensions must match for addition");
-    }
-    
-    GridVec result(nx, ny, nz);
-    for (int i = 0; i < nx; i++) {
-        for (int j = 0; j < ny; j++) {
-            for (int k = 0; k < nz; k++) {
-                result.data[i][j][k] = data[i][j][k] + grid.data[i][j][k];
-            }
-        }
-    }
-    return result;
-}
-
-// Multiplication by scalar (member function)
-GridVec GridVec::operator*(double factor) const {
-    GridVec result(nx, ny, nz);
-    for (int i = 0; i < nx; i++) {
-        for (int j = 0; j < ny; j++) {
-            for (int k = 0; k < nz; k++) {
-                result.data[i][j][k] = data[i][j][k] * factor;
-            }
-        }
-    }
-    return result;
-}
-
-// Multiplication by scalar (friend function)
-GridVec operator*(double factor, const GridVec& grid) {
-    return grid * factor;
-}
-
 // Prefix increment: increment every element by 1
 GridVec& GridVec::operator++() {
     for (int i = 0; i < nx; i++) {
@@ -12,7 +12,9 @@ Method 1)
 #include <iostream>
 #include <vector>
 
-class GridVec {
+#include "grid3d_expr.h"
+
+class GridVec : public GridExpr<GridVec> {
 public:
     GridVec(int nx_ = 1, int ny_ = 1, int nz_ = 1);
     ~GridVec();
@@ -25,16 +27,64 @@ public:
     // Set a value. Using operator() is more elegant, but requires
     // more knowledge to implement
     void set(int i, int j, int k, double value);
-    GridVec operator+(const GridVec& grid) const;
-    GridVec operator*(double factor) const;
-    friend GridVec operator*(double factor, const GridVec& grid);
     GridVec& operator++();
     GridVec& operator+=(const GridVec& grid);
+    template <class E>
+    GridVec& operator+=(const GridExpr<E>& expr);
     friend std::ostream& operator<<(std::ostream& os, const GridVec& grid);
 
+    // Arithmetic (+, -, *, / with grids and scalars) builds expressions, see
+    // grid3d_expr.h; these evaluate one into the grid in a single pass
+    template <class E>
+    GridVec(const GridExpr<E>& expr);
+    template <class E>
+    GridVec& operator=(const GridExpr<E>& expr);
+
+    // Expression interface
+    typedef const double* Pencil;
+    static const bool contiguous = false;
+    int getNx() const { return nx; }
+    int getNy() const { return ny; }
+    int getNz() const { return nz; }
+    Pencil pencil(int i, int j) const { return data[i][j].data(); }
+
 private:
+    template <class Store, class Grid, class E>
+    friend void evaluateGrid(Grid& grid, const E& expr);
+    double* output(int i, int j) { return data[i][j].data(); }
+
     std::vector<std::vector<std::vector<double> > > data;
     int nx, ny, nz;
 };
 
+template <class E>
+GridVec::GridVec(const GridExpr<E>& expr)
+    : data(expr.self().getNx(), std::vector<std::vector<double> >(expr.self().getNy(),
+          std::vector<double>(expr.self().getNz()))),
+      nx(expr.self().getNx()), ny(expr.self().getNy()), nz(expr.self().getNz()) {
+    evaluateGrid<GridStore>(*this, expr.self());
+}
+
+template <class E>
+GridVec& GridVec::operator=(const GridExpr<E>& expr) {
+    const E& e = expr.self();
+    // An expression with other dimensions cannot refer to this grid, so the
+    // old values can be dropped before evaluating it
+    if (nx != e.getNx() || ny != e.getNy() || nz != e.getNz()) {
+        nx = e.getNx();
+        ny = e.getNy();
+        nz = e.getNz();
+        data.assign(nx, std::vector<std::vector<double> >(ny, std::vector<double>(nz)));
+    }
+    evaluateGrid<GridStore>(*this, e);
+    return *this;
+}
+
+template <class E>
+GridVec& GridVec::operator+=(const GridExpr<E>& expr) {
+    checkGridDimensions(*this, expr.self(), "addition");
+    evaluateGrid<GridAddStore>(*this, expr.self());
+    return *this;
+}
+
 #endif
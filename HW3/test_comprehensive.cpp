@@ -4,6 +4,7 @@
 #include <iostream>
 #include <cassert>
 #include <chrono>
+#include <stdexcept>
 
 using namespace std;
 
@@ -54,6 +55,26 @@ void test_grid1d() {
     assert(grid(0, 0, 0) == 4.5);
     cout << " += operator test passed" << endl;
     
+    // Test expressions: evaluated in one pass, without temporaries
+    Grid1D expr = 2.0 * grid + grid4 * 3.0 - 1.0;
+    assert(expr(0, 0, 0) == 14.0 && expr(1, 2, 3) == 1.0);
+    expr += grid * grid4 / 2.0;
+    assert(expr(0, 0, 0) == 18.5 && expr(1, 2, 3) == 1.0);
+    expr = expr - grid;
+    assert(expr(0, 0, 0) == 14.0 && expr(1, 2, 3) == 0.0);
+    assert((grid + grid4)(0, 0, 0) == 6.5);
+    Grid1D other(3, 3, 3);
+    bool mismatch = false;
+    try {
+        (void)(grid + other * 2.0);
+    } catch (const invalid_argument&) {
+        mismatch = true;
+    }
+    assert(mismatch);
+    other = -grid;
+    assert(other.getSize() == 24 && other(0, 0, 0) == -4.5);
+    cout << " Expression test passed" << endl;
+    
     cout << "Grid1D memory usage: " << grid.getMemory() << " bytes" << endl;
     cout << "All Grid1D tests passed!" << endl << endl;
 }
@@ -105,6 +126,26 @@ void test_gridvec() {
     assert(grid(0, 0, 0) == 4.5);
     cout << " += operator test passed" << endl;
     
+    // Test expressions: evaluated in one pass, without temporaries
+    GridVec expr = 2.0 * grid + grid4 * 3.0 - 1.0;
+    assert(expr(0, 0, 0) == 14.0 && expr(1, 2, 3) == 1.0);
+    expr += grid * grid4 / 2.0;
+    assert(expr(0, 0, 0) == 18.5 && expr(1, 2, 3) == 1.0);
+    expr = expr - grid;
+    assert(expr(0, 0, 0) == 14.0 && expr(1, 2, 3) == 0.0);
+    assert((grid + grid4)(0, 0, 0) == 6.5);
+    GridVec other(3, 3, 3);
+    bool mismatch = false;
+    try {
+        (void)(grid + other * 2.0);
+    } catch (const invalid_argument&) {
+        mismatch = true;
+    }
+    assert(mismatch);
+    other = -grid;
+    assert(other.getSize() == 24 && other(0, 0, 0) == -4.5);
+    cout << " Expression test passed" << endl;
+    
     cout << "GridVec memory usage: " << grid.getMemory() << " bytes" << endl;
     cout << "All GridVec tests passed!" << endl << endl;
 }
@@ -156,6 +197,42 @@ void test_gridnew() {
     assert(grid(0, 0, 0) == 4.5);
     cout << " += operator test passed" << endl;
     
+    // Test storage: every element is distinct, copies are deep, and
+    // assignment works across different dimensions
+    GridNew filled(3, 4, 5);
+    for (int i = 0; i < 3; i++)
+        for (int j = 0; j < 4; j++)
+            for (int k = 0; k < 5; k++)
+                filled.set(i, j, k, 100 * i + 10 * j + k);
+    GridNew copy(filled);
+    filled.set(2, 3, 4, -1.0);
+    assert(copy(2, 3, 4) == 234.0 && copy(1, 2, 3) == 123.0);
+    grid3 = copy;
+    assert(grid3.getSize() == 60 && grid3(2, 0, 4) == 204.0);
+    grid3 += copy * 2.0;
+    assert(grid3(1, 3, 0) == 390.0);
+    cout << " Storage test passed" << endl;
+    
+    // Test expressions: evaluated in one pass, without temporaries
+    GridNew expr = 2.0 * grid + grid4 * 3.0 - 1.0;
+    assert(expr(0, 0, 0) == 14.0 && expr(1, 2, 3) == 1.0);
+    expr += grid * grid4 / 2.0;
+    assert(expr(0, 0, 0) == 18.5 && expr(1, 2, 3) == 1.0);
+    expr = expr - grid;
+    assert(expr(0, 0, 0) == 14.0 && expr(1, 2, 3) == 0.0);
+    assert((grid + grid4)(0, 0, 0) == 6.5);
+    GridNew other(3, 3, 3);
+    bool mismatch = false;
+    try {
+        (void)(grid + other * 2.0);
+    } catch (const invalid_argument&) {
+        mismatch = true;
+    }
+    assert(mismatch);
+    other = -grid;
+    assert(other.getSize() == 24 && other(0, 0, 0) == -4.5);
+    cout << " Expression test passed" << endl;
+    
     cout << "GridNew memory usage: " << grid.getMemory() << " bytes" << endl;
     cout << "All GridNew tests passed!" << endl << endl;
 }